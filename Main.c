@@ -1,6 +1,9 @@
 #include <nds.h>
 #include <nds/fifocommon.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <maxmod9.h>
 
 extern const u8 soundbank_bin_end[];
@@ -11,77 +14,342 @@ extern const u32 soundbank_bin_size;
 #include "gfx/bgbottom.png.h"
 #include "gfx/bgtop.png.h"
 #include "gfx/bgtop_menu.png.h"
+#include "gfx/font.png.h"
 #include "gfx/girder.h"
 #include "gfx/png_shared.h"
 #include "gfx/ghosties.h"
 #include "soundbank.h"
+#include "game.h"
+#include "lz77.h"
+#include "dma.h"
+#include "platform.h"
+#include "prof.h"
+#include "replay.h"
+#include "sprites.h"
 
-// gfx
-u16* puc;
-u16* puc_sub;
-u16* gird;
-u16* gird_sub;
-u16* ghosties;
-
-// girder positions
-float girdx[4];
-float girdy[4];
-
-void drawGirds(){
-	for( int i = 0; i < 4; i++ ) {
-		if( girdy[i] <= 193 ) {
-			oamSet(
-				&oamMain,
-				2*(i+1)-1, girdx[i], girdy[i], 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				gird,
-				-1, false, false, false, false, false
-			);
-			oamSet(
-				&oamMain,
-				2*(i+1), girdx[i]+28, girdy[i], 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				gird,
-				-1, false, false, false, false, false
-			);
-			oamClear(&oamSub,2*(i+1)-1,2);
+// Sprite gfx, each only loaded on the screens it shows on. The two
+// engines have their own sprite VRAM, so those on both are there twice.
+// Like the backgrounds, they are LZ77 packed (grit -gzl) and unpacked
+// straight into VRAM.
+typedef struct Asset
+{
+	const unsigned int* tiles;
+	SpriteSize size;
+	int screens;
+} Asset;
+
+const Asset assets[] = {
+	[GFX_PUC] = { pucmcawesomeTiles, SpriteSize_32x32*6, 1<<SCREEN_MAIN | 1<<SCREEN_SUB },
+	[GFX_GIRD] = { girderTiles, SpriteSize_32x64, 1<<SCREEN_MAIN | 1<<SCREEN_SUB },
+	[GFX_GHOST] = { ghostiesTiles, SpriteSize_32x32*6, 1<<SCREEN_SUB },
+};
+
+// Build with -DLZ_BIOS to unpack with the BIOS instead, to compare.
+static void unpack(const void* src, void* dst){
+#ifdef LZ_BIOS
+	decompress(src, dst, LZ77Vram);
+#else
+	lzDecompressVram(src, dst);
+#endif
+}
+
+// shadow OAM, committed by the VBlank IRQ once spr_ready is set, and
+// multiplexed by the VCount IRQ
+SprOam spr[2];
+volatile bool spr_ready = false;
+
+// tile index of each gfx per screen, in 128 byte units
+int spr_tile[3][2];
+#define FRAME_TILES ((32*32)>>7)
+
+// Top screen backgrounds. All of them stay in VRAM bank B, 64K each at
+// the given bitmap base, so a switch is only background 3's base and
+// the palette. Both go in at VBlank, with the sprites of that frame.
+typedef struct Scene
+{
+	const unsigned int* bitmap;
+	const unsigned short* pal;
+	int base;			// in 16K units
+} Scene;
+
+const Scene scenes[] = {
+	[BG_GAME] = { bgtop_pngBitmap, bgtop_pngPal, 0 },
+	[BG_MENU] = { bgtop_menu_pngBitmap, bgtop_menu_pngPal, 4 },
+};
+
+// background 3 on the main screen
+int bg;
+int bg_pending = -1;
+volatile int bg_switch = -1;		// for the VBlank IRQ
+
+static void countDown(void* arg){
+	(*(int*)arg)--;
+}
+
+// Debug overlay, toggled with R: the sprite cycles each line asks for
+// (see sprites.h) as a bar over the right edge of both backgrounds,
+// red where it's over budget. L turns the flicker scheduler off and on.
+#define BUDGET_X	224
+#define BUDGET_OK	254		// bg palette entries the bars take over
+#define BUDGET_OVER	255
+bool budget_overlay = false;
+bool budget_shown = false;
+u16* bg_vram[2];
+const u16* bg_pal[2];
+u16 budget_under[2][SPR_LINES*16];	// the background under the bars
+bool budget_saved[2];
+
+// Profiler overlay, toggled with X: min, average and max per section
+// over the last PROF_FRAMES frames, in gfx/font.png on a 4 bit text
+// layer over the sub screen. Its map is in the 16K below bgbottom and
+// the font past it; the ink takes over one bg palette entry.
+#define PROF_MAP_BASE	0
+#define PROF_TILE_BASE	5
+#define PROF_PAL		15
+#define PROF_INK		(PROF_PAL*16+1)
+int prof_bg;
+bool prof_overlay = false;
+u32 frame_count;
+
+void platSprite(int x, int y, int prio, int gfx, int frame, bool hflip){
+	int tile[2] = {
+		spr_tile[gfx][SCREEN_MAIN] + frame*FRAME_TILES,
+		spr_tile[gfx][SCREEN_SUB] + frame*FRAME_TILES
+	};
+	sprAddWorld(spr, x, y, prio, tile, hflip);
+}
+
+void platBackground(int which){
+	bg_pending = which;
+}
+
+u32 platTicks(void){
+	return cpuGetTiming();
+}
+
+void platCue(int cue){
+	if( cue == CUE_MUSIC ) {
+		mmStart( MOD_OH_SCHEISSE_MP , MM_PLAY_LOOP );
+	}
+}
+
+static void commitOam(SprOam* t, u16* oam){
+	int first;
+	int n = sprDirtySpan(t, &first);
+	if( n ) {
+		DC_FlushRange(&t->oam[first*4], n*8);
+		dmaCopyWords(0, &t->oam[first*4], oam + first*4, n*8);
+	}
+	sprClean(t);
+}
+
+static void writeEntry(u16* oam, const SprRewrite* r){
+	u16* e = oam + r->slot*4;
+	e[0] = r->attr[0];
+	e[1] = r->attr[1];
+	e[2] = r->attr[2];
+}
+
+// multiplexer rewrites done so far this frame, per screen
+int mux_next[2];
+
+static void armVCount(){
+	int line = -1;
+	for( int s = SCREEN_MAIN; s <= SCREEN_SUB; s++ ) {
+		const SprMux* m = sprMux(&spr[s]);
+		if( mux_next[s] < m->count && (line < 0 || m->rw[mux_next[s]].line < line) ) {
+			line = m->rw[mux_next[s]].line;
 		}
-		else {
-			oamSet(
-				&oamSub,
-				2*(i+1)-1, girdx[i], girdy[i]-198, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				gird_sub,
-				-1, false, false, false, false, false
-			);
-			oamSet(
-				&oamSub,
-				2*(i+1), girdx[i]+28, girdy[i]-198, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				gird_sub,
-				-1, false, false, false, false, false
-			);
-			oamClear(&oamMain,2*(i+1)-1,2);
+	}
+	if( line < 0 ) {
+		irqDisable(IRQ_VCOUNT);
+	}
+	else {
+		SetYtrigger(line);
+		irqEnable(IRQ_VCOUNT);
+	}
+}
+
+static void vcount(){
+	int line = REG_VCOUNT;
+	u16* oam[2] = { OAM, OAM_SUB };
+	for( int s = SCREEN_MAIN; s <= SCREEN_SUB; s++ ) {
+		const SprMux* m = sprMux(&spr[s]);
+		while( mux_next[s] < m->count && m->rw[mux_next[s]].line <= line ) {
+			writeEntry(oam[s], &m->rw[mux_next[s]++]);
+		}
+	}
+	armVCount();
+}
+
+// Only here and in vcount() is OAM written: first the multiplexed slots
+// go back to the top of frame, then a finished frame goes in.
+static void vblank(){
+	u16* oam[2] = { OAM, OAM_SUB };
+	for( int s = SCREEN_MAIN; s <= SCREEN_SUB; s++ ) {
+		const SprMux* m = sprMux(&spr[s]);
+		for( int i = 0; i < m->restores; i++ ) {
+			writeEntry(oam[s], &m->restore[i]);
+		}
+	}
+	if( spr_ready ) {
+		u32 t0 = cpuGetTiming();
+		commitOam(&spr[SCREEN_MAIN], OAM);
+		commitOam(&spr[SCREEN_SUB], OAM_SUB);
+		spr_ready = false;
+		profAdd(PROF_OAM, cpuGetTiming() - t0);
+	}
+	// its palette is a VBlank job on the DMA queue
+	if( bg_switch >= 0 ) {
+		bgSetMapBase(bg, scenes[bg_switch].base);
+		bg_switch = -1;
+	}
+	dmaVBlank();
+	mux_next[SCREEN_MAIN] = mux_next[SCREEN_SUB] = 0;
+	armVCount();
+}
+
+// Bars for the frame just committed, or with on false the background
+// put back. What they cover is kept from when they first go up, as the
+// packed image can't be read from.
+static void drawBudget(int s, bool on){
+	const SprOam* t = &spr[s];
+	u16* pal = s == SCREEN_MAIN ? BG_PALETTE : BG_PALETTE_SUB;
+
+	if( on && !budget_saved[s] ) {
+		for( int line = 0; line < SPR_LINES; line++ ) {
+			memcpy(&budget_under[s][line*16], bg_vram[s] + (line*256 + BUDGET_X)/2, 32);
+		}
+	}
+	budget_saved[s] = on;
+
+	pal[BUDGET_OK] = on ? RGB15(0,31,0) : bg_pal[s][BUDGET_OK];
+	pal[BUDGET_OVER] = on ? RGB15(31,0,0) : bg_pal[s][BUDGET_OVER];
+	for( int line = 0; line < SPR_LINES; line++ ) {
+		// VRAM takes no byte writes, so two pixels at a time
+		u16* dst = bg_vram[s] + (line*256 + BUDGET_X)/2;
+		const u16* src = &budget_under[s][line*16];
+		int cost = t->cost[line];
+		bool over = cost > SPR_LINE_CYCLES;
+		int w = !on ? 0 : over ? 16 : cost*16 / SPR_LINE_CYCLES;
+		u16 c = over ? BUDGET_OVER | BUDGET_OVER<<8 : BUDGET_OK | BUDGET_OK<<8;
+		for( int i = 0; i < 16; i++ ) {
+			dst[i] = i < w ? c : src[i];
+		}
+	}
+}
 
+// The font is 8 bit with 0 as the background; the text layer is 4 bit
+// with everything else as ink.
+static void loadFont(){
+	const u8* src = (const u8*)font_pngTiles;
+	u32* dst = (u32*)bgGetGfxPtr(prof_bg);
+	for( int row = 0; row < font_pngTilesLen/8; row++ ) {
+		u32 bits = 0;
+		for( int x = 0; x < 8; x++ ) {
+			if( src[row*8 + x] ) {
+				bits |= 1u << x*4;
+			}
 		}
+		dst[row] = bits;
+	}
+}
+
+// The font starts at space.
+static void printAt(int x, int y, const char* text){
+	u16* map = bgGetMapPtr(prof_bg) + y*32;
+	for( ; *text && x < 32; x++ ) {
+		map[x] = (*text++ - ' ') | PROF_PAL<<12;
+	}
+}
+
+static void showProf(bool on){
+	if( on ) {
+		dmaQueueFill(PROF_PAL<<12 | PROF_PAL<<28, bgGetMapPtr(prof_bg), 32*24*2, DMA_PRIO_HIGH, 0, NULL, NULL);
+		dmaWait();
+		BG_PALETTE_SUB[PROF_INK] = RGB15(31,31,31);
+		bgShow(prof_bg);
+	}
+	else {
+		bgHide(prof_bg);
+		BG_PALETTE_SUB[PROF_INK] = bg_pal[SCREEN_SUB][PROF_INK];
 	}
 }
 
+// In microseconds to a tenth.
+static void drawProf(){
+	char line[40];
+	u32 total = 0;
+
+	printAt(0, 0, "section   min    avg    max us");
+	for( int s = 0; s < PROF_SECTIONS; s++ ) {
+		ProfStats st;
+		profStats(s, &st);
+		total += st.avg;
+		snprintf(line, sizeof(line), "%-8s%4lu.%lu %4lu.%lu %4lu.%lu",
+			profName(s),
+			(unsigned long)st.min/1000, (unsigned long)st.min/100%10,
+			(unsigned long)st.avg/1000, (unsigned long)st.avg/100%10,
+			(unsigned long)st.max/1000, (unsigned long)st.max/100%10);
+		printAt(0, 1+s, line);
+	}
+	snprintf(line, sizeof(line), "frame          %4lu.%lu",
+		(unsigned long)total/1000, (unsigned long)total/100%10);
+	printAt(0, 1+PROF_SECTIONS, line);
+}
+
+// Show what the game set this frame.
+static void platFrame(){
+	profBegin(PROF_SPRITES);
+	sprEnd(&spr[SCREEN_MAIN]);
+	sprEnd(&spr[SCREEN_SUB]);
+	profEnd();
+	spr_ready = true;
+
+	if( bg_pending >= 0 ) {
+		const Scene* sc = &scenes[bg_pending];
+		// no bars left behind in the one going away
+		if( budget_shown ) {
+			drawBudget(SCREEN_MAIN, false);
+		}
+		bg_vram[SCREEN_MAIN] = BG_BMP_RAM(sc->base);
+		bg_pal[SCREEN_MAIN] = (const u16*)sc->pal;
+		// both at the same VBlank
+		int ime = enterCriticalSection();
+		dmaQueueCopy(sc->pal, BG_PALETTE, 256*2, DMA_PRIO_HIGH, DMA_AT_VBLANK, NULL, NULL);
+		bg_switch = bg_pending;
+		leaveCriticalSection(ime);
+		bg_pending = -1;
+	}
+	profBegin(PROF_WAIT);
+	swiWaitForVBlank();
+	profEnd();
+	dmaPoll();
+	sprBegin(&spr[SCREEN_MAIN]);
+	sprBegin(&spr[SCREEN_SUB]);
+
+	profBegin(PROF_DEBUG);
+	if( budget_overlay || budget_shown ) {
+		drawBudget(SCREEN_MAIN, budget_overlay);
+		drawBudget(SCREEN_SUB, budget_overlay);
+		budget_shown = budget_overlay;
+	}
+	if( prof_overlay && (frame_count & 15) == 0 ) {
+		drawProf();
+	}
+	profEnd();
+	profFrame();
+	frame_count++;
+}
+
 int main()
 {
 // 	irqInit();
 // 	irqEnable(IRQ_VBLANK);
 // 	fifoInit();
 
-	int mode = 1;
-
 	mmInitDefaultMem((mm_addr)soundbank_bin);
 	mmLoad( MOD_OH_SCHEISSE_MP );
-	mmStart( MOD_OH_SCHEISSE_MP , MM_PLAY_LOOP );
 	
 	videoSetMode(MODE_5_2D);
 	videoSetModeSub(MODE_5_2D);
@@ -94,246 +362,121 @@ int main()
 	oamInit(&oamMain, SpriteMapping_1D_128, false);
 	oamInit(&oamSub, SpriteMapping_1D_128, false);
 
-	// Load puc
-	puc = oamAllocateGfx(&oamMain, SpriteSize_32x32*6, SpriteColorFormat_256Color);
-	dmaCopy((u8*)pucmcawesomeTiles, puc, 32*32*6);
-	puc_sub = oamAllocateGfx(&oamSub, SpriteSize_32x32*6, SpriteColorFormat_256Color);
-	dmaCopy((u8*)pucmcawesomeTiles, puc_sub, 32*32*6);
+	// The sprite gfx and backgrounds are LZ77 packed and unpacked into
+	// VRAM by the CPU right here; only the palettes go through the DMA
+	// queue, and the sprite ones are waited for below.
+	int uploads = 0;
+	dmaInit();
 
+	// Load sprite gfx
+	for( int i = 0; i < sizeof(assets)/sizeof(assets[0]); i++ ) {
+		for( int screen = SCREEN_MAIN; screen <= SCREEN_SUB; screen++ ) {
+			if( assets[i].screens & 1<<screen ) {
+				OamState* oam = screen == SCREEN_MAIN ? &oamMain : &oamSub;
+				u16* gfx = oamAllocateGfx(oam, assets[i].size, SpriteColorFormat_256Color);
+				unpack(assets[i].tiles, gfx);
+				spr_tile[i][screen] = oamGfxPtrToOffset(oam, gfx);
+			}
+		}
+	}
 
-	// Load girder
-	gird = oamAllocateGfx(&oamMain, SpriteSize_32x64, SpriteColorFormat_256Color);
-	dmaCopy((u8*)girderTiles, gird, 32*64*2);
-	gird_sub = oamAllocateGfx(&oamSub, SpriteSize_32x64, SpriteColorFormat_256Color);
-	dmaCopy((u8*)girderTiles, gird_sub, 32*64*2);
-
-	// Load ghosties
-	ghosties = oamAllocateGfx(&oamSub, SpriteSize_32x32*6, SpriteColorFormat_256Color);
-	dmaCopy((u8*)ghostiesTiles, ghosties, 32*32*6);
+	sprInit(&spr[SCREEN_MAIN]);
+	sprInit(&spr[SCREEN_SUB]);
+	spr[SCREEN_MAIN].flicker = true;
+	spr[SCREEN_SUB].flicker = true;
+	irqSet(IRQ_VBLANK, vblank);
+	irqSet(IRQ_VCOUNT, vcount);
+	irqEnable(IRQ_VBLANK);
 
 	// Palette
-	dmaCopy(png_sharedPal, SPRITE_PALETTE, 512);
-	dmaCopy(png_sharedPal, SPRITE_PALETTE_SUB, 512);
+	uploads += 2;
+	dmaQueueCopy(png_sharedPal, SPRITE_PALETTE, 512, DMA_PRIO_HIGH, 0, countDown, &uploads);
+	dmaQueueCopy(png_sharedPal, SPRITE_PALETTE_SUB, 512, DMA_PRIO_HIGH, 0, countDown, &uploads);
 
-	int bg = bgInit(3, BgType_Bmp8, BgSize_B8_256x256, 0,0);
+	// gameInit() picks the first scene
+	for( int i = 0; i < sizeof(scenes)/sizeof(scenes[0]); i++ ) {
+		unpack(scenes[i].bitmap, BG_BMP_RAM(scenes[i].base));
+	}
+	bg = bgInit(3, BgType_Bmp8, BgSize_B8_256x256, scenes[BG_GAME].base, 0);
 	bgSetPriority(bg, 2);
-	dmaCopy(bgtop_pngBitmap, bgGetGfxPtr(bg), 256*256);
-	dmaCopy(bgtop_pngPal, BG_PALETTE, 256*2);
 
 	int bg2 = bgInitSub(3, BgType_Bmp8, BgSize_B8_256x256, 1,0);
 	bgSetPriority(bg2, 2);
-	dmaCopy(bgbottom_pngBitmap, bgGetGfxPtr(bg2), 256*256);
-	dmaCopy(bgbottom_pngPal, BG_PALETTE_SUB, 256*2);
-
-	int x = (256-32)/2.0;
-	int y = 0;
-	bool nose_right = 0;
-	float acc_x = 0;
-	float acc_y = 0;
-	int frame = 0;
-	int framedelay = 0;
-	float gird_accel=0.2;
-	bool grounded = false;
-	float t;
-	float s;
-	// Girdpos init
-	for(int i = 0; i < 4; i++ ) {
-		girdy[i] = (384/4) * i;
-		girdx[i] = rand() % 200;
+	unpack(bgbottom_pngBitmap, bgGetGfxPtr(bg2));
+	dmaQueueCopy(bgbottom_pngPal, BG_PALETTE_SUB, 256*2, DMA_PRIO_LOW, 0, NULL, NULL);
+	bg_vram[SCREEN_SUB] = bgGetGfxPtr(bg2);
+	bg_pal[SCREEN_SUB] = (const u16*)bgbottom_pngPal;
+
+	prof_bg = bgInitSub(0, BgType_Text4bpp, BgSize_T_256x256, PROF_MAP_BASE, PROF_TILE_BASE);
+	bgSetPriority(prof_bg, 0);
+	loadFont();
+	showProf(false);
+
+	while( uploads > 0 ) {
+		dmaPoll();
 	}
 
-start:
-	s = 0;
-	dmaCopy(bgtop_pngBitmap, bgGetGfxPtr(bg), 256*256);
-	dmaCopy(bgtop_pngPal, BG_PALETTE, 256*2);
-	
-	while( mode == 0 ) {
-// 		iprintf("\n Lets print pretty text on the\n NDS screen ");
-// 		iprintf("\x1b[32musing devkitpro!\n\n");
-// 		iprintf("\x1b[32;1m All we need now is actual game\n code!\x1b[39m");
+	// Every game is recorded from boot on; SELECT in the menu plays the
+	// last one back, after which a new recording starts.
+	static Game game;
+	static u8 replay_buf[32*1024];
+	Replay replay;
+	bool replaying = false;
+
+	// timers 0 and 1, cascaded
+	cpuStartTiming(0);
+	profInit(BUS_CLOCK);
+
+	u32 seed = time(NULL);
+	gameInit(&game, seed);
+	replayRecordBegin(&replay, replay_buf, sizeof(replay_buf), seed);
+	platFrame();
+
+	for(;;) {
+		profBegin(PROF_INPUT);
 		scanKeys();
-		int keys = keysHeld();
-		t+=0.05;
-		s += 1/60.0;
-		
-		if( keys & KEY_A) {
-			// Should be: "on platform"
-			if(grounded) {
-				acc_y = 4;
-				grounded = false;
-			}
-		}
-		if( keys & KEY_RIGHT) {
-			acc_x = -2;
-			nose_right = true;
-		} else if( keys & KEY_LEFT) {
-			acc_x = 2;
-			nose_right = false;
-		} else {
-			acc_x = 0;
-		}
+		u32 keys = keysHeld();
 
-		// Move puc
-		for(int i = 0; i < 4; i++ ) {
-			bool found_ground = 0;
-			if( x > girdx[i]-16 && x < girdx[i]+50 && y < (int)girdy[i]-26 && y>(int)girdy[i] - 33){
-				acc_y = gird_accel;
-				grounded = true;
-			}
-		}
-		y -= acc_y - gird_accel/2.0;
-		x -= acc_x;
-		if( x < -32 ) {
-			x = 256+32;
+		if( keysDown() & KEY_R ) {
+			budget_overlay = !budget_overlay;
 		}
-		if( x > 256+32 ) {
-			x = -31;
+		if( keysDown() & KEY_X ) {
+			prof_overlay = !prof_overlay;
+			showProf(prof_overlay);
 		}
-		if(acc_y > -5.0) {
-			acc_y-= 0.1;
-		}
-		
-		if( y >= 384-32 ) {
-			acc_y = 0;
-			y = 384-32;
-			// DIE
-			mode = 1;
-		}
-		framedelay = (framedelay + 1)%3;
-		if(framedelay == 0) {
-			frame = (frame + 1) % 6;
+		if( keysDown() & KEY_L ) {
+			spr[SCREEN_MAIN].flicker = !spr[SCREEN_MAIN].flicker;
+			spr[SCREEN_SUB].flicker = spr[SCREEN_MAIN].flicker;
 		}
 
-		// Move girds
-		for(int i = 0; i < 4; i++ ) {
-			girdy[i] += gird_accel;
-			if(girdy[i] > 384) {
-				girdy[i] = 0;
-				girdx[i] = rand() % 200;
+		if( replaying ) {
+			if( !replayPlay(&replay, &keys) ) {
+				replaying = false;
+				seed = time(NULL);
+				gameInit(&game, seed);
+				replayRecordBegin(&replay, replay_buf, sizeof(replay_buf), seed);
+				profEnd();
+				platFrame();
+				continue;
 			}
 		}
-		gird_accel+=0.001;
-		
-		// Draw things on screen.
-		if( y <= 193 ) {
-			oamSet(
-				&oamMain,
-				0, x, y, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				puc + (frame * 32 * 32)/2,
-				-1, false, false, nose_right, false, false
-			);
-		}
-		if( y >= 193-32 ) {
-			oamSet(
-				&oamSub,
-				0, x, y-198, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				puc_sub + (frame * 32 * 32)/2,
-				-1, false, false, nose_right, false, false
-			);
-		}
-
-		// Ghosties
-		for( int i = 0; i < 20; i++ ) {
-			oamSet(
-				&oamSub,
-				10+i, i*20-32*4+(int)(t*20.0)%(20*3), 167+sin(t*2.0)*5.0+sin((i*20-32*4+(int)(t*20.0)%(20*3))/20.0)*10.0, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				ghosties + ((i%3) * 32 * 32)/2,
-				-10, false, false, true, false, false
-			);
-			oamSet(
-				&oamSub,
-				30+i, 256-i*20+32*4-(int)(t*25.0)%(20*3), 175+cos(t*2.3)*5.0+cos((256-i*20+32*4-(int)(t*25.0)%(20*3))/20.0)*10.0, 0, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				ghosties + ((i%3) * 32 * 32)/2,
-				-10, false, false, false, false, false
-			);
-		}
-		
-		drawGirds();
-
-		swiWaitForVBlank();
-		oamUpdate(&oamMain);
-		oamUpdate(&oamSub);
-	}
-	dmaCopy(bgtop_menu_pngBitmap, bgGetGfxPtr(bg), 256*256);
-	dmaCopy(bgtop_menu_pngPal, BG_PALETTE, 256*2);
-
-	while( mode == 1 ) {
-// 		iprintf("\n Lets print pretty text on the\n NDS screen ");
-// 		iprintf("\x1b[32musing devkitpro!\n\n");
-// 		iprintf("\x1b[32;1m All we need now is actual game\n code!\x1b[39m");
-		scanKeys();
-		int keys = keysHeld();
-		if( keys & KEY_START ) {
-			mode = 0;
-		}
-		framedelay = (framedelay + 1)%3;
-		if(framedelay == 0) {
-			frame = (frame + 1) % 6;
+		else if( game.mode == MODE_MENU && (keysDown() & KEY_SELECT) ) {
+			u32 size = replayRecordEnd(&replay);
+			if( replayPlayBegin(&replay, replay_buf, size) ) {
+				replaying = true;
+				gameInit(&game, replay.seed);
+				profEnd();
+				platFrame();
+				continue;
+			}
 		}
-		
-		// Reset.
-		x = (256-32)/2.0;
-		y = 0;
-		nose_right = 0;
-		acc_x = 0;
-		acc_y = 0;
-		frame = 0;
-		framedelay = 0;
-		gird_accel=0.2;
-		grounded = false;
-
-		// Girdpos init
-		for(int i = 0; i < 4; i++ ) {
-			girdy[i] = (384/4) * i;
-			girdx[i] = rand() % 200;
+		else {
+			replayRecord(&replay, keys);
 		}
+		profEnd();
 
-
-		// Ghosties
-		t+=0.05;
-		for( int i = 0; i < 20; i++ ) {
-			oamSet(
-				&oamSub,
-				10+i, i*20-32*4+(int)(t*20.0)%(20*3), 167+sin(t*2.0)*5.0+sin((i*20-32*4+(int)(t*20.0)%(20*3))/20.0)*10.0, 1, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				ghosties + ((i%3) * 32 * 32)/2,
-				-10, false, false, true, false, false
-			);
-			oamSet(
-				&oamSub,
-				50+i, 256-i*20+32*4-(int)(t*25.0)%(20*3), 175+cos(t*2.3)*5.0+cos((256-i*20+32*4-(int)(t*25.0)%(20*3))/20.0)*10.0, 0, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				ghosties + ((i%3) * 32 * 32)/2,
-				-10, false, false, false, false, false
-			);
-			oamSet(
-				&oamSub,
-				30+i, i*20-32*4+(int)(t*10.0)%(20*3), 185+sin(t*2.0)*5.0+sin((i*20-32*4+(int)(t*10.0)%(20*3))/20.0)*4.0, 0, 0,
-				SpriteSize_32x32,
-				SpriteColorFormat_256Color,
-				ghosties + ((i%3) * 32 * 32)/2,
-				-10, false, false, true, false, false
-			);
-		}
-		
-		swiWaitForVBlank();
-		oamClear(&oamMain,0,0);
-		oamClear(&oamSub,0,10);
-		oamUpdate(&oamMain);
-		oamUpdate(&oamSub);
+		gameStep(&game, keys);
+		platFrame();
 	}
-
-	goto start;
 	return 0;
 }
-	
\ No newline at end of file
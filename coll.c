@@ -0,0 +1,61 @@
+#include "coll.h"
+
+static void place(CollBands* b, int p, int i){
+	b->idx[p] = i;
+	b->pos[i] = p;
+}
+
+void collClear(CollBands* b){
+	for( int k = 0; k <= COLL_BANDS; k++ ) {
+		b->start[k] = 0;
+	}
+}
+
+// Moves i one band boundary at a time: swap it with the end of its run
+// that faces the target band, then move that boundary past it.
+void collMove(CollBands* b, int i, int band){
+	int p = b->pos[i];
+	int k = b->band[i];
+
+	for( ; k < band; k++ ) {
+		int q = b->start[k+1] - 1;
+		place(b, p, b->idx[q]);
+		place(b, q, i);
+		b->start[k+1] = q;
+		p = q;
+	}
+	for( ; k > band; k-- ) {
+		int q = b->start[k];
+		place(b, p, b->idx[q]);
+		place(b, q, i);
+		b->start[k] = q + 1;
+		p = q;
+	}
+	b->band[i] = band;
+}
+
+// File entity i, just spawned at the end of the pool, by its top y.
+void collAdd(CollBands* b, int i, int y){
+	place(b, b->start[COLL_BANDS]++, i);
+	b->band[i] = COLL_BANDS-1;
+	collMove(b, i, collBand(y));
+}
+
+// Unfile entity i before entDespawn(e, i) moves entity last into it.
+void collRemove(CollBands* b, int i, int last){
+	collMove(b, i, COLL_BANDS-1);
+	int q = --b->start[COLL_BANDS];
+	place(b, b->pos[i], b->idx[q]);
+	if( last != i ) {
+		place(b, b->pos[last], i);
+		b->band[i] = b->band[last];
+	}
+}
+
+// Girders with their top anywhere in top..bottom, and maybe a few more
+// from the same bands. Returns how many; *idx points at the first.
+int collQuery(const CollBands* b, int top, int bottom, const u8** idx){
+	int first = b->start[collBand(top)];
+	*idx = &b->idx[first];
+	return b->start[collBand(bottom)+1] - first;
+}
@@ -0,0 +1,59 @@
+//
+//  coll.h : Broadphase for things landing on girders.
+//
+/* === NOTES ===
+	Girders only move in y, so they are filed into horizontal bands of
+	COLL_BAND pixels by their top. idx holds the pool's indices sorted
+	by band, start[] where each band's run begins; collQuery() then
+	gives the indices of all girders whose top is in the bands a y range
+	touches, as one run. Cost of a query is the girders near the player,
+	not all of them.
+
+	The bands live as long as the pool and are kept up to date rather
+	than rebuilt: collAdd() and collRemove() go with entSpawn() and
+	entDespawn(), collUpdate() after a move. Only a girder that changed
+	band costs anything, a swap per band boundary it crossed, so a frame
+	of falling girders is a compare each plus the few that moved on.
+	collcheck runs all of them, despawns included, against a model.
+*/
+
+#ifndef __COLL_H__
+#define __COLL_H__
+
+#include "types.h"
+#include "ents.h"
+
+#define COLL_BAND_SHIFT	5
+#define COLL_BAND		(1<<COLL_BAND_SHIFT)
+#define COLL_BANDS		16		// tops at 0..511; above and below go in the ends
+
+typedef struct CollBands
+{
+	u16 start[COLL_BANDS+1];
+	u8 idx[ENT_MAX];	// pool indices, sorted by band
+	u8 pos[ENT_MAX];	// where each pool index is in idx
+	u8 band[ENT_MAX];	// and the band it's filed under
+} CollBands;
+
+static inline int collBand(int y)
+{
+	y >>= COLL_BAND_SHIFT;
+	return y < 0 ? 0 : y >= COLL_BANDS ? COLL_BANDS-1 : y;
+}
+
+void collClear(CollBands* b);
+void collAdd(CollBands* b, int i, int y);
+void collRemove(CollBands* b, int i, int last);
+void collMove(CollBands* b, int i, int band);
+int collQuery(const CollBands* b, int top, int bottom, const u8** idx);
+
+// Entity i's top is now at y; refile it if that's another band.
+static inline void collUpdate(CollBands* b, int i, int y)
+{
+	int k = collBand(y);
+	if( k != b->band[i] ) {
+		collMove(b, i, k);
+	}
+}
+
+#endif // __COLL_H__
@@ -0,0 +1,148 @@
+//
+//  collcheck.c : Host check of the girder bands against their pool.
+//
+/* === NOTES ===
+	Spawns, despawns and moves entities at random, with entSpawn() and
+	collAdd(), collRemove() and entDespawn(), and collUpdate(), the way
+	game code has to pair them. A model of the pool follows along, each
+	entity carrying an id in home so a despawn's move of the last one
+	into the hole can be followed.
+
+	After every step idx and pos must be each other's inverse over the
+	live entities, start[] must mark off runs whose band[] is theirs and
+	matches their y, and the pool must still hold what the model says.
+	Now and then a collQuery() is held against a scan of all of them.
+	The pool is run up to full and back down to empty a few times.
+
+	Usage: collcheck [steps]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coll.h"
+
+static Ents pool;
+static CollBands bands;
+static int modelY[ENT_MAX], modelId[ENT_MAX];
+static u32 lcg= 1;
+static long errors;
+
+static int rnd(int n)
+{
+	lcg= lcg*1664525 + 1013904223;
+	return (lcg>>8) % n;
+}
+
+static void check(bool ok, const char *what, long step)
+{
+	if(!ok && errors++ < 10)
+		printf("failed at step %ld: %s\n", step, what);
+}
+
+//! A y from a bit above the top band to a bit below the bottom one.
+static int rndY()
+{
+	return rnd(COLL_BANDS*COLL_BAND + 128) - 64;
+}
+
+static void checkBands(long step)
+{
+	bool seen[ENT_MAX];
+	int k, p, i;
+
+	check(bands.start[0] == 0 && bands.start[COLL_BANDS] == pool.count, "start[] ends", step);
+	memset(seen, 0, sizeof(seen));
+	for(k=0; k<COLL_BANDS; k++)
+	{
+		check(bands.start[k] <= bands.start[k+1], "start[] order", step);
+		for(p=bands.start[k]; p<bands.start[k+1] && p<pool.count; p++)
+		{
+			i= bands.idx[p];
+			check(i < pool.count && !seen[i], "idx is a permutation", step);
+			if(i >= pool.count)
+				continue;
+			seen[i]= true;
+			check(bands.pos[i] == p, "pos is idx's inverse", step);
+			check(bands.band[i] == k, "band[] matches start[]", step);
+			check(collBand(fx20toint(pool.y[i])) == k, "band matches y", step);
+		}
+	}
+	for(i=0; i<pool.count; i++)
+		check(pool.home[i] == modelId[i] && pool.y[i] == inttofx20(modelY[i]), "pool matches model", step);
+}
+
+static void checkQuery(long step)
+{
+	int top= rndY(), bottom= top + rnd(96);
+	int k0= collBand(top), k1= collBand(bottom);
+	const u8 *idx;
+	int n= collQuery(&bands, top, bottom, &idx), want= 0, i, j;
+
+	for(i=0; i<pool.count; i++)
+	{
+		int k= collBand(modelY[i]);
+		if(k < k0 || k > k1)
+			continue;
+		want++;
+		for(j=0; j<n && idx[j] != i; j++)
+			;
+		check(j < n, "query has every girder in range", step);
+	}
+	check(n == want, "query has only girders in range", step);
+}
+
+int main(int argc, char *argv[])
+{
+	long steps= argc>1 ? strtol(argv[1], NULL, 0) : 2000000;
+	long step;
+	int nextId= 1, i, last;
+
+	pool.count= 0;
+	collClear(&bands);
+
+	for(step=0; step<steps; step++)
+	{
+		// Lean towards spawning, then despawning, every 100000 steps.
+		int spawnOdds= step/100000 % 2 ? 2 : 6;
+		int op= rnd(10);
+
+		if(op < spawnOdds && pool.count < ENT_MAX)
+		{
+			i= entSpawn(&pool);
+			modelY[i]= rndY();
+			modelId[i]= nextId++;
+			pool.y[i]= inttofx20(modelY[i]);
+			pool.home[i]= modelId[i];
+			collAdd(&bands, i, modelY[i]);
+		}
+		else if(op < 8 && pool.count > 0)
+		{
+			i= rnd(pool.count);
+			last= pool.count-1;
+			collRemove(&bands, i, last);
+			entDespawn(&pool, i);
+			modelY[i]= modelY[last];
+			modelId[i]= modelId[last];
+		}
+		else if(pool.count > 0)
+		{
+			// Mostly falling a little and wrapping back to the top, as
+			// girders do, sometimes a jump.
+			i= rnd(pool.count);
+			modelY[i]= rnd(4) ? modelY[i] + rnd(COLL_BAND) : rndY();
+			if(modelY[i] > COLL_BANDS*COLL_BAND + 64)
+				modelY[i]= -64;
+			pool.y[i]= inttofx20(modelY[i]);
+			collUpdate(&bands, i, modelY[i]);
+		}
+
+		checkBands(step);
+		if(step % 16 == 0)
+			checkQuery(step);
+	}
+
+	printf("%ld steps, %ld errors\n", steps, errors);
+	return errors != 0;
+}
@@ -0,0 +1,270 @@
+#include <string.h>
+#include <stdint.h>
+#ifdef ARM9
+#include <nds.h>
+#endif
+
+#include "dma.h"
+
+#define DMA_CHANNELS	4
+
+enum
+{
+	JOB_FREE,
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,			// callback still to come from dmaPoll()
+};
+
+typedef struct DmaJob
+{
+	const void* src;
+	void* dst;
+	u32 bytes;
+	u32 value;			// for fills
+	u32 seq;
+	u8 state, prio, flags;
+	bool fill;
+	DmaDone done;
+	void* arg;
+} DmaJob;
+
+bool dma_blocking = false;
+
+static DmaJob jobs[DMA_JOBS];
+static s8 running[DMA_CHANNELS];
+static u32 seq;
+
+static bool words(const DmaJob* j){
+	return (((uintptr_t)j->src | (uintptr_t)j->dst | j->bytes) & 3) == 0;
+}
+
+#ifdef ARM9
+
+static int lock(void){
+	return enterCriticalSection();
+}
+
+static void unlock(int ime){
+	leaveCriticalSection(ime);
+}
+
+static void hwStart(int ch, const DmaJob* j){
+	u32 cr = DMA_ENABLE | DMA_START_NOW;
+	if( words(j) ) {
+		cr |= DMA_32_BIT | j->bytes>>2;
+	}
+	else {
+		cr |= DMA_16_BIT | j->bytes>>1;
+	}
+	if( j->fill ) {
+		DMA_FILL(ch) = j->value;
+		DMA_SRC(ch) = (u32)&DMA_FILL(ch);
+		cr |= DMA_SRC_FIX;
+	}
+	else {
+		DMA_SRC(ch) = (u32)j->src;
+	}
+	DMA_DEST(ch) = (u32)j->dst;
+	DMA_CR(ch) = cr;
+}
+
+static bool hwBusy(int ch){
+	return DMA_CR(ch) & DMA_BUSY;
+}
+
+#else
+
+static int lock(void){
+	return 0;
+}
+
+static void unlock(int ime){
+}
+
+static void hwStart(int ch, const DmaJob* j){
+}
+
+static bool hwBusy(int ch){
+	return false;
+}
+
+#endif
+
+// What the channel does, by CPU: the blocking fallback, and the host's
+// stand-in for the hardware.
+static void transfer(const DmaJob* j){
+	if( words(j) ) {
+		u32* dst = j->dst;
+		const u32* src = j->src;
+		for( u32 i = 0; i < j->bytes/4; i++ ) {
+			dst[i] = j->fill ? j->value : src[i];
+		}
+	}
+	else {
+		u16* dst = j->dst;
+		const u16* src = j->src;
+		for( u32 i = 0; i < j->bytes/2; i++ ) {
+			dst[i] = j->fill ? j->value : src[i];
+		}
+	}
+}
+
+// Channels that have finished give their jobs to dmaPoll().
+static void reap(void){
+	for( int ch = DMA_FIRST; ch < DMA_CHANNELS; ch++ ) {
+		int k = running[ch];
+		if( k >= 0 && !hwBusy(ch) ) {
+#ifndef ARM9
+			transfer(&jobs[k]);
+#endif
+			jobs[k].state = JOB_DONE;
+			running[ch] = -1;
+		}
+	}
+}
+
+// The queued job to go next, of the VBlank ones or the others.
+static int pick(bool vblank){
+	int best = -1;
+	for( int k = 0; k < DMA_JOBS; k++ ) {
+		const DmaJob* j = &jobs[k];
+		if( j->state != JOB_QUEUED || !(j->flags & DMA_AT_VBLANK) != !vblank ) {
+			continue;
+		}
+		if( best < 0 || j->prio < jobs[best].prio ||
+			(j->prio == jobs[best].prio && (s32)(j->seq - jobs[best].seq) < 0) ) {
+			best = k;
+		}
+	}
+	return best;
+}
+
+static void startFree(bool vblank){
+	for( int ch = DMA_FIRST; ch < DMA_CHANNELS; ch++ ) {
+		if( running[ch] < 0 ) {
+			int k = pick(vblank);
+			if( k < 0 ) {
+				return;
+			}
+			jobs[k].state = JOB_RUNNING;
+			running[ch] = k;
+			hwStart(ch, &jobs[k]);
+		}
+	}
+}
+
+void dmaInit(void){
+	memset(jobs, 0, sizeof(jobs));
+	memset(running, -1, sizeof(running));
+}
+
+static int freeSlot(void){
+	for( int k = 0; k < DMA_JOBS; k++ ) {
+		if( jobs[k].state == JOB_FREE ) {
+			return k;
+		}
+	}
+	return -1;
+}
+
+// A full queue is polled until a slot frees up, rather than doing the
+// job by CPU: that could overtake jobs still running to the same place,
+// or put a VBlank job in mid-frame.
+static bool queue(const DmaJob* job){
+	int ime = lock();
+	int k;
+
+	while( (k = freeSlot()) < 0 ) {
+		unlock(ime);
+		dmaPoll();
+#ifndef ARM9
+		// no IRQ to do it
+		dmaVBlank();
+#endif
+		ime = lock();
+	}
+	jobs[k] = *job;
+	jobs[k].seq = seq++;
+	jobs[k].state = JOB_QUEUED;
+	if( !(job->flags & DMA_AT_VBLANK) ) {
+		startFree(false);
+	}
+	unlock(ime);
+
+	if( dma_blocking ) {
+		dmaWait();
+		return false;
+	}
+	return true;
+}
+
+// Both return false if the job was already done, with dma_blocking.
+bool dmaQueueCopy(const void* src, void* dst, u32 bytes, int prio, int flags, DmaDone done, void* arg){
+	DmaJob j = { src, dst, bytes, 0, 0, JOB_QUEUED, prio, flags, false, done, arg };
+#ifdef ARM9
+	DC_FlushRange(src, bytes);
+#endif
+	return queue(&j);
+}
+
+bool dmaQueueFill(u32 value, void* dst, u32 bytes, int prio, int flags, DmaDone done, void* arg){
+	DmaJob j = { NULL, dst, bytes, value, 0, JOB_QUEUED, prio, flags, true, done, arg };
+	return queue(&j);
+}
+
+// Callbacks are called with the queue unlocked, so they can queue more.
+void dmaPoll(void){
+	DmaDone done[DMA_JOBS];
+	void* arg[DMA_JOBS];
+	int n = 0;
+	int ime = lock();
+
+	reap();
+	for( int k = 0; k < DMA_JOBS; k++ ) {
+		if( jobs[k].state == JOB_DONE ) {
+			done[n] = jobs[k].done;
+			arg[n++] = jobs[k].arg;
+			jobs[k].state = JOB_FREE;
+		}
+	}
+	startFree(false);
+	unlock(ime);
+
+	for( int i = 0; i < n; i++ ) {
+		if( done[i] ) {
+			done[i](arg[i]);
+		}
+	}
+}
+
+// From the VBlank IRQ. All the VBlank jobs go now, waiting for a
+// channel if there are more of them than channels.
+void dmaVBlank(void){
+	int ime = lock();
+	reap();
+	startFree(true);
+	while( pick(true) >= 0 ) {
+		reap();
+		startFree(true);
+	}
+	unlock(ime);
+}
+
+void dmaWait(void){
+	while( dmaPending() ) {
+		dmaPoll();
+#ifndef ARM9
+		// no IRQ to do it
+		dmaVBlank();
+#endif
+	}
+}
+
+int dmaPending(void){
+	int n = 0;
+	for( int k = 0; k < DMA_JOBS; k++ ) {
+		n += jobs[k].state != JOB_FREE;
+	}
+	return n;
+}
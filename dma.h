@@ -0,0 +1,62 @@
+//
+//  dma.h : Queue of DMA copies and fills, spread over the free channels.
+//
+/* === NOTES ===
+	dmaQueueCopy() and dmaQueueFill() put a job in the queue and return
+	right away. dmaPoll() reaps the channels that are done, calls their
+	jobs' callbacks and starts the next jobs, lowest prio first and in
+	queue order within a prio, on whichever of channels DMA_FIRST to 3
+	are free. Channel 0 is left to the VBlank IRQ, which does its OAM
+	commit there itself.
+
+	Jobs flagged DMA_AT_VBLANK wait for dmaVBlank(), which the VBlank
+	IRQ calls: they start then, ahead of anything else, so VRAM, OAM
+	and palette writes can go in while nothing is drawn. Their
+	callbacks still come from dmaPoll().
+
+	Sizes are in bytes; with source, destination and size all multiples
+	of 4 the copy goes by words, otherwise by halfwords. VRAM takes no
+	byte writes, so that is as small as it gets. The source is flushed
+	from the data cache when the job is queued.
+
+	When the queue is full, queueing polls until a job is done and its
+	slot is free; with only VBlank jobs queued that is the next VBlank,
+	so don't queue from an IRQ handler. With dma_blocking set, queueing
+	waits for the job, callback included, and everything before it.
+	dmaWait() blocks until everything queued is done. Either way the
+	memory is only safe to touch once the callback has run.
+
+	On the host a channel "runs" from the dmaPoll() or dmaVBlank() that
+	starts it to the next one of either, where the copy happens, so the
+	order things become visible in is the same as on the DS.
+*/
+
+#ifndef __DMA_H__
+#define __DMA_H__
+
+#include "types.h"
+
+#define DMA_JOBS		32
+#define DMA_FIRST		1		// channels DMA_FIRST..3 are the queue's
+
+// flags
+#define DMA_AT_VBLANK	1
+
+// prio, lower goes first
+#define DMA_PRIO_HIGH	0
+#define DMA_PRIO_NORMAL	1
+#define DMA_PRIO_LOW	2
+
+typedef void (*DmaDone)(void* arg);
+
+extern bool dma_blocking;
+
+void dmaInit(void);
+bool dmaQueueCopy(const void* src, void* dst, u32 bytes, int prio, int flags, DmaDone done, void* arg);
+bool dmaQueueFill(u32 value, void* dst, u32 bytes, int prio, int flags, DmaDone done, void* arg);
+void dmaPoll(void);
+void dmaVBlank(void);
+void dmaWait(void);
+int dmaPending(void);
+
+#endif // __DMA_H__
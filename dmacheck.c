@@ -0,0 +1,141 @@
+//
+//  dmacheck.c : Host check of the DMA queue's ordering rules.
+//
+/* === NOTES ===
+	Runs dma.c's host emulation through what Main.c relies on: jobs
+	land by prio and then queue order, VBlank jobs wait for dmaVBlank(),
+	a full queue waits for a free slot, fills go by words or
+	halfwords, and a callback may queue the next job.
+
+	Usage: dmacheck
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dma.h"
+
+static int order[64], done;
+static long errors;
+
+static void check(bool ok, const char *what)
+{
+	if(!ok && errors++ < 10)
+		printf("failed: %s\n", what);
+}
+
+static void note(void *arg)
+{
+	order[done++]= (int)(long)arg;
+}
+
+static u16 chain_dst[8];
+static const u16 chain_src[8]= { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+static void chain(void *arg)
+{
+	note(arg);
+	dmaQueueCopy(chain_src, chain_dst, sizeof(chain_src), DMA_PRIO_HIGH, 0, note, (void*)99);
+}
+
+int main()
+{
+	static u32 src[64], dst[DMA_JOBS+8][64];
+	static u16 half[7];
+	int i;
+
+	for(i=0; i<64; i++)
+		src[i]= i*0x01010101u;
+
+	// The first 3 go straight onto the free channels; the rest by prio.
+	dmaInit();
+	done= 0;
+	for(i=0; i<8; i++)
+		dmaQueueCopy(src, dst[i], 256, i<3 ? DMA_PRIO_LOW : 7-i < 3 ? DMA_PRIO_HIGH : DMA_PRIO_NORMAL, 0, note, (void*)(long)i);
+	check(dst[0][1] == 0, "copy visible before dmaPoll()");
+	dmaWait();
+	{
+		static const int want[8]= { 0, 1, 2, 5, 6, 7, 3, 4 };
+		check(done == 8 && memcmp(order, want, sizeof(want)) == 0, "prio, then queue order");
+	}
+	for(i=0; i<8; i++)
+		check(memcmp(dst[i], src, 256) == 0, "copied");
+
+	// VBlank jobs wait for it, then all go at once.
+	dmaInit();
+	done= 0;
+	memset(dst, 0, sizeof(dst));
+	for(i=0; i<5; i++)
+		dmaQueueCopy(src, dst[i], 64, DMA_PRIO_NORMAL, DMA_AT_VBLANK, note, (void*)(long)i);
+	dmaPoll();
+	dmaPoll();
+	check(done == 0 && dst[0][1] == 0, "VBlank job ran early");
+	dmaVBlank();
+	dmaPoll();
+	check(done == 5 && memcmp(dst[4], src, 64) == 0, "VBlank jobs all done");
+
+	// Full queue: the next job waits for a slot, and goes after the
+	// ones before it. Here they all write to the same place, the VBlank
+	// ones by their index and the last one by 99; a copy that overtook
+	// the rest would be overwritten.
+	{
+		static u32 tags[DMA_JOBS+1][16];
+
+		dmaInit();
+		done= 0;
+		memset(dst, 0, sizeof(dst));
+		for(i=0; i<=DMA_JOBS; i++)
+			tags[i][0]= i<DMA_JOBS ? i : 99;
+		for(i=0; i<DMA_JOBS; i++)
+			check(dmaQueueCopy(tags[i], dst[0], 64, DMA_PRIO_NORMAL, DMA_AT_VBLANK, note, (void*)(long)i), "queued");
+		check(dst[0][0] == 0 && done == 0, "VBlank job ran before a full queue");
+		check(dmaQueueCopy(tags[DMA_JOBS], dst[0], 64, DMA_PRIO_NORMAL, 0, note, (void*)99), "full queue");
+		check(done >= 1 && order[0] == 0, "full queue waited for a slot");
+		dmaWait();
+		check(done == DMA_JOBS+1 && order[DMA_JOBS] == 99, "full queue kept the order");
+		check(dst[0][0] == 99, "full queue's job went last");
+
+		// A VBlank job on a full queue still waits for dmaVBlank().
+		dmaInit();
+		done= 0;
+		memset(dst, 0, sizeof(dst));
+		for(i=0; i<DMA_JOBS; i++)
+			dmaQueueCopy(src, dst[1], 64, DMA_PRIO_NORMAL, 0, NULL, NULL);
+		dmaQueueCopy(src, dst[0], 64, DMA_PRIO_NORMAL, DMA_AT_VBLANK, note, (void*)7);
+		check(done == 0 && dst[0][1] == 0, "VBlank job on a full queue ran early");
+		dmaPoll();
+		dmaPoll();
+		check(done == 0 && dst[0][1] == 0, "VBlank job on a full queue ran early");
+		dmaWait();
+		check(done == 1 && memcmp(dst[0], src, 64) == 0, "VBlank job on a full queue done");
+	}
+
+	// Fills by words and by halfwords.
+	dmaInit();
+	memset(half, 0, sizeof(half));
+	dmaQueueFill(0xF00DF00D, dst[0], 256, DMA_PRIO_NORMAL, 0, NULL, NULL);
+	dmaQueueFill(0xBEEF, half, sizeof(half), DMA_PRIO_NORMAL, 0, NULL, NULL);
+	dmaWait();
+	check(dst[0][0] == 0xF00DF00D && dst[0][63] == 0xF00DF00D, "word fill");
+	check(half[0] == 0xBEEF && half[6] == 0xBEEF, "halfword fill");
+
+	// A callback queueing more.
+	dmaInit();
+	done= 0;
+	dmaQueueCopy(src, dst[0], 4, DMA_PRIO_NORMAL, 0, chain, (void*)1);
+	dmaWait();
+	check(done == 2 && order[1] == 99 && memcmp(chain_dst, chain_src, sizeof(chain_src)) == 0, "chained job");
+
+	// Blocking: done by the time it returns, after what was queued.
+	dmaInit();
+	done= 0;
+	memset(dst, 0, sizeof(dst));
+	dmaQueueCopy(src, dst[0], 64, DMA_PRIO_LOW, 0, note, (void*)1);
+	dma_blocking= true;
+	check(!dmaQueueCopy(src, dst[1], 4, DMA_PRIO_NORMAL, 0, note, (void*)2), "blocking");
+	dma_blocking= false;
+	check(done == 2 && order[0] == 1 && dst[1][0] == src[0] && dst[0][15] == src[15], "blocking waits for all");
+
+	printf("%ld errors\n", errors);
+	return errors != 0;
+}
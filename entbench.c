@@ -0,0 +1,106 @@
+//
+//  entbench.c : Host timing of the game step against entity counts.
+//
+/* === NOTES ===
+	Fills the girder and ghost pools up to various sizes and times
+	gameStep() with a do-nothing platform, so what's left is update,
+	collision and draw setup. The cost per extra entity is the slope
+	from the smallest pool to the largest.
+
+	Usage: entbench [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "game.h"
+#include "platform.h"
+
+static u32 sink;
+
+void platSprite(int x, int y, int prio, int gfx, int frame, bool hflip)
+{
+	sink += x ^ y;
+}
+
+void platBackground(int bg)	{	}
+void platCue(int cue)		{	}
+u32 platTicks(void)			{	return 0;	}
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+//! Grow a pool to n by copying what's there, so new ones act the same.
+//! Girders also go into their bands.
+static void fill(Ents *e, CollBands *bands, int n)
+{
+	int have= e->count;
+
+	while(e->count < n)
+	{
+		int k= entSpawn(e), s= k % have;
+		e->x[k]= e->x[s];
+		e->y[k]= e->y[s] + inttofx20(k*7 % 384);
+		e->vx[k]= e->vx[s];
+		e->home[k]= e->home[s];
+		e->frame[k]= e->frame[s];
+		e->tag[k]= e->tag[s];
+		e->flags[k]= e->flags[s];
+		if(bands)
+			collAdd(bands, k, fx20toint(e->y[k]));
+	}
+}
+
+//! ns per frame with the given pool sizes; START is held, so a death
+//! goes straight back into play.
+static double timeStep(int girds, int ghosts, u32 frames)
+{
+	static Game game;
+	double t0;
+	u32 i;
+
+	gameInit(&game, 1);
+	fill(&game.girds, &game.gird_bands, girds);
+	fill(&game.ghosts, NULL, ghosts);
+
+	t0= nsNow();
+	for(i=0; i<frames; i++)
+		gameStep(&game, GKEY_START | (i & 64 ? GKEY_A | GKEY_LEFT : GKEY_RIGHT));
+	return (nsNow()-t0)/frames;
+}
+
+int main(int argc, char *argv[])
+{
+	static const int sizes[]= { 4, 16, 64, 128, ENT_MAX };
+	const int nSizes= sizeof(sizes)/sizeof(sizes[0]);
+	u32 frames= argc>1 ? strtoul(argv[1], NULL, 0) : 200000;
+	double ns[2][8];
+	int i, g0= -1;
+
+	// There are always the 3 rows of ghosts.
+	printf("%8s %14s %14s\n", "entities", "girders ns/f", "ghosts ns/f");
+	for(i=0; i<nSizes; i++)
+	{
+		ns[0][i]= timeStep(sizes[i], GHOSTS*3, frames);
+		printf("%8d %14.1f", sizes[i], ns[0][i]);
+		if(sizes[i] >= GHOSTS*3)
+		{
+			ns[1][i]= timeStep(GIRDS, sizes[i], frames);
+			printf(" %14.1f", ns[1][i]);
+			if(g0 < 0)
+				g0= i;
+		}
+		printf("\n");
+	}
+	printf("per girder: %.2f ns, per ghost: %.2f ns%s\n",
+		(ns[0][nSizes-1]-ns[0][0])/(sizes[nSizes-1]-sizes[0]),
+		(ns[1][nSizes-1]-ns[1][g0])/(sizes[nSizes-1]-sizes[g0]),
+		sink == 42 ? " " : "");
+
+	return 0;
+}
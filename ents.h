@@ -0,0 +1,64 @@
+//
+//  ents.h : Pools of entities, one array per field.
+//
+/* === NOTES ===
+	Each kind of thing (girders, ghosts) gets its own Ents pool, and the
+	update and draw loops run over 0..count-1 of the fields they need,
+	so they only touch memory they use. Live entities are always packed
+	at the front: entDespawn() moves the last one into the hole, so
+	don't hold on to indices across a despawn.
+
+	Positions and speeds are fx20 world pixels. home is where an entity
+	that scrolls round wraps back to; tag is for the kind to use, ghosts
+	keep their row in it.
+*/
+
+#ifndef __ENTS_H__
+#define __ENTS_H__
+
+#include "types.h"
+#include "fixed.h"
+
+#define ENT_MAX			256
+
+// flags
+#define ENT_HFLIP		(1<<0)
+#define ENT_MENU		(1<<1)	// only drawn in the menu
+
+typedef struct Ents
+{
+	int count;
+	fx20 x[ENT_MAX];
+	fx20 y[ENT_MAX];
+	fx20 vx[ENT_MAX];
+	fx20 home[ENT_MAX];
+	u8 frame[ENT_MAX];
+	u8 tag[ENT_MAX];
+	u8 flags[ENT_MAX];
+} Ents;
+
+// Index of a new entity with all fields 0, or -1 if the pool is full.
+static inline int entSpawn(Ents* e)
+{
+	int i = e->count;
+	if(i >= ENT_MAX)
+		return -1;
+	e->count++;
+	e->x[i] = e->y[i] = e->vx[i] = e->home[i] = 0;
+	e->frame[i] = e->tag[i] = e->flags[i] = 0;
+	return i;
+}
+
+static inline void entDespawn(Ents* e, int i)
+{
+	int last = --e->count;
+	e->x[i] = e->x[last];
+	e->y[i] = e->y[last];
+	e->vx[i] = e->vx[last];
+	e->home[i] = e->home[last];
+	e->frame[i] = e->frame[last];
+	e->tag[i] = e->tag[last];
+	e->flags[i] = e->flags[last];
+}
+
+#endif // __ENTS_H__
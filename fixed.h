@@ -0,0 +1,67 @@
+//
+//  fixed.h : Fixed point for the game simulation.
+//
+/* === NOTES ===
+	fx12 is 19.12, the same as libnds f32. fx20 is 11.20 for things
+	that add up small steps over many frames: the girder speed grows by
+	0.001 a frame, which Q12 gets 2.3% wrong and Q20 0.04%. The player's
+	vertical speed is fx20 too: y is truncated to whole pixels every
+	frame, and in Q12 that truncation sometimes lands a pixel off the
+	old float code.
+
+	FX12() and FX20() convert constants and round; the compiler folds
+	them, so no float code ends up in the binary. The *toint() helpers
+	floor, the *trunc() ones round towards zero like a float to int
+	cast does. The add/sub helpers saturate instead of wrapping.
+*/
+
+#ifndef __FIXED_H__
+#define __FIXED_H__
+
+#include "types.h"
+
+typedef s32 fx12;
+typedef s32 fx20;
+
+#define FX12_SHIFT		12
+#define FX20_SHIFT		20
+
+#define FX12(_c)		((fx12)((_c)*4096.0 + ((_c) < 0 ? -0.5 : 0.5)))
+#define FX20(_c)		((fx20)((_c)*1048576.0 + ((_c) < 0 ? -0.5 : 0.5)))
+
+static inline fx12 inttofx12(int n)		{	return n << FX12_SHIFT;		}
+static inline fx20 inttofx20(int n)		{	return n << FX20_SHIFT;		}
+
+static inline int fx12toint(fx12 a)		{	return a >> FX12_SHIFT;		}
+static inline int fx20toint(fx20 a)		{	return a >> FX20_SHIFT;		}
+
+static inline fx12 fx20tofx12(fx20 a)	{	return a >> (FX20_SHIFT-FX12_SHIFT);	}
+static inline fx20 fx12tofx20(fx12 a)	{	return a << (FX20_SHIFT-FX12_SHIFT);	}
+
+static inline int fx12trunc(fx12 a)
+{
+	return (a + ((a >> 31) & ((1<<FX12_SHIFT)-1))) >> FX12_SHIFT;
+}
+
+static inline int fx20trunc(fx20 a)
+{
+	return (a + ((a >> 31) & ((1<<FX20_SHIFT)-1))) >> FX20_SHIFT;
+}
+
+static inline s32 fxAddSat(s32 a, s32 b)
+{
+	s32 r;
+	if(__builtin_add_overflow(a, b, &r))
+		return a < 0 ? INT32_MIN : INT32_MAX;
+	return r;
+}
+
+static inline s32 fxSubSat(s32 a, s32 b)
+{
+	s32 r;
+	if(__builtin_sub_overflow(a, b, &r))
+		return a < 0 ? INT32_MIN : INT32_MAX;
+	return r;
+}
+
+#endif // __FIXED_H__
@@ -0,0 +1,316 @@
+#include "game.h"
+#include "platform.h"
+#include "coll.h"
+#include "prof.h"
+
+// Ghost waves, filled once by the first gameInit().
+static s16 ghost_wave4[OSC_WAVE_SIZE];
+static s16 ghost_wave5[OSC_WAVE_SIZE];
+static s16 ghost_wave10[OSC_WAVE_SIZE];
+static bool ghost_waves_done = false;
+
+// xorshift32; the state lives in the Game so replays come out the same.
+static u32 gameRand(Game* g){
+	u32 r = g->rng;
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	g->rng = r;
+	return r;
+}
+
+static void resetGirds(Game* g){
+	Ents* e = &g->girds;
+	for( int i = 0; i < e->count; i++ ) {
+		e->y[i] = inttofx20((384/e->count) * i);
+		e->x[i] = inttofx20(gameRand(g) % 200);
+		collUpdate(&g->gird_bands, i, fx20toint(e->y[i]));
+	}
+}
+
+static void resetPuc(Game* g){
+	g->x = (256-32)/2;
+	g->y = 0;
+	g->prev_y = 0;
+	g->nose_right = 0;
+	g->acc_x = 0;
+	g->acc_y = 0;
+	g->frame = 0;
+	g->framedelay = 0;
+	g->gird_accel = FX20(0.2);
+	g->gird_step = 0;
+	g->grounded = false;
+}
+
+static void drawGirds(const Game* g){
+	const Ents* e = &g->girds;
+	for( int i = 0; i < e->count; i++ ) {
+		int gx = fx20toint(e->x[i]);
+		int gy = fx20trunc(e->y[i]);
+		platSprite(gx, gy, 1, GFX_GIRD, 0, false);
+		platSprite(gx+28, gy, 1, GFX_GIRD, 0, false);
+	}
+}
+
+// Ghosts come in rows that scroll sideways and wrap every 60 pixels.
+// Ghost y is the row's y + bob + wave(x/20), where the wave carries the
+// amplitude and shift turns its sine into a cosine.
+typedef struct GhostRow
+{
+	int x, dx;			// first ghost, spacing
+	int y;
+	fx20 vx;
+	const s16* wave;
+	u32 shift;
+	int bob;			// 0: ghost_bob_a, 1: ghost_bob_b
+	int prio;
+	u8 flags;
+} GhostRow;
+
+static const GhostRow ghost_rows[] = {
+	{ -32*4, 20, SUB_Y+167, FX20(1), ghost_wave10, 0, 0, 1, ENT_HFLIP },
+	{ -32*4, 20, SUB_Y+185, FX20(0.5), ghost_wave4, 0, 0, 0, ENT_HFLIP | ENT_MENU },
+	{ 256+32*4, -20, SUB_Y+175, FX20(-1.25), ghost_wave10, OSC_QUARTER, 1, 0, 0 },
+};
+
+#define GHOST_WRAP inttofx20(60)
+
+static void spawnGhosts(Game* g){
+	Ents* e = &g->ghosts;
+	for( int r = 0; r < sizeof(ghost_rows)/sizeof(ghost_rows[0]); r++ ) {
+		const GhostRow* row = &ghost_rows[r];
+		for( int i = 0; i < GHOSTS; i++ ) {
+			int k = entSpawn(e);
+			if( k < 0 ) {
+				return;
+			}
+			// Going left, start just under the next pixel so x floors to
+			// the same pixels as counting the scroll up and subtracting.
+			e->home[k] = inttofx20(row->x + i*row->dx) + (row->vx < 0 ? inttofx20(1)-1 : 0);
+			e->x[k] = e->home[k];
+			e->y[k] = inttofx20(row->y);
+			e->vx[k] = row->vx;
+			e->frame[k] = i%3;
+			e->tag[k] = r;
+			e->flags[k] = row->flags;
+		}
+	}
+}
+
+static void moveGhosts(Game* g){
+	Ents* e = &g->ghosts;
+	for( int i = 0; i < e->count; i++ ) {
+		e->x[i] += e->vx[i];
+		if( e->x[i] - e->home[i] >= GHOST_WRAP ) {
+			e->x[i] -= GHOST_WRAP;
+		}
+		else if( e->home[i] - e->x[i] >= GHOST_WRAP ) {
+			e->x[i] += GHOST_WRAP;
+		}
+	}
+	oscBankStep(&g->ghost_bob_a);
+	oscBankStep(&g->ghost_bob_b);
+}
+
+static void drawGhosts(const Game* g, bool menu){
+	const Ents* e = &g->ghosts;
+	int bob[2] = {
+		oscWave(g->ghost_bob_a.wave, g->ghost_bob_a.phase),
+		oscWave(g->ghost_bob_b.wave, g->ghost_bob_b.phase)
+	};
+
+	for( int i = 0; i < e->count; i++ ) {
+		if( !menu && (e->flags[i] & ENT_MENU) ) {
+			continue;
+		}
+
+		const GhostRow* row = &ghost_rows[e->tag[i]];
+		int x = fx20toint(e->x[i]);
+		int y = (fx20toint(e->y[i])<<OSC_FP) + bob[row->bob]
+			+ oscWave(row->wave, (u32)x*OSC_RAD(1/20.0) + row->shift);
+		platSprite(x, y>>OSC_FP, row->prio, GFX_GHOST, e->frame[i], e->flags[i] & ENT_HFLIP);
+	}
+}
+
+// Puc stands on a girder when its top is 27 to 32 pixels above the
+// girder's. Checking only that can miss when puc and girder move more
+// than 6 pixels apart in a frame, so it also counts as landing when
+// they were on either side of that range last frame.
+#define LAND_LO		(-32)
+#define LAND_HI		(-27)
+
+static bool landed(const Game* g){
+	const Ents* e = &g->girds;
+	fx20 step = g->gird_step;
+	int reach = fx20toint(step) + 1;
+	const u8* idx;
+
+	int n = collQuery(&g->gird_bands,
+		(g->y < g->prev_y ? g->y : g->prev_y) - LAND_HI,
+		(g->y > g->prev_y + reach ? g->y : g->prev_y + reach) - LAND_LO,
+		&idx);
+
+	for( int k = 0; k < n; k++ ) {
+		int i = idx[k];
+		int gx = fx20toint(e->x[i]);
+		if( g->x <= gx-16 || g->x >= gx+50 ) {
+			continue;
+		}
+		int rel = g->y - fx20trunc(e->y[i]);
+		if( rel >= LAND_LO && rel <= LAND_HI ) {
+			return true;
+		}
+		// A girder that just went back to the top has no last frame.
+		if( e->y[i] >= step ) {
+			int was = g->prev_y - fx20trunc(e->y[i] - step);
+			if( (was < LAND_LO && rel > LAND_HI) || (was > LAND_HI && rel < LAND_LO) ) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void stepPlay(Game* g, u32 keys){
+	moveGhosts(g);
+
+	if( keys & GKEY_A) {
+		// Should be: "on platform"
+		if(g->grounded) {
+			g->acc_y = inttofx20(4);
+			g->grounded = false;
+			platCue(CUE_JUMP);
+		}
+	}
+	if( keys & GKEY_RIGHT) {
+		g->acc_x = inttofx12(-2);
+		g->nose_right = true;
+	} else if( keys & GKEY_LEFT) {
+		g->acc_x = inttofx12(2);
+		g->nose_right = false;
+	} else {
+		g->acc_x = 0;
+	}
+
+	// Move puc
+	profBegin(PROF_COLL);
+	if( landed(g) ) {
+		g->acc_y = g->gird_accel;
+		g->grounded = true;
+	}
+	profEnd();
+	g->prev_y = g->y;
+	// float steps were truncated to whole pixels, keep doing that
+	g->y = fx20trunc(inttofx20(g->y) - (g->acc_y - g->gird_accel/2));
+	g->x -= fx12toint(g->acc_x);
+	if( g->x < -32 ) {
+		g->x = 256+32;
+	}
+	if( g->x > 256+32 ) {
+		g->x = -31;
+	}
+	if(g->acc_y > inttofx20(-5)) {
+		g->acc_y = fxSubSat(g->acc_y, FX20(0.1));
+	}
+
+	if( g->y >= 384-32 ) {
+		g->acc_y = 0;
+		g->y = 384-32;
+		// DIE
+		g->mode = MODE_MENU;
+		platCue(CUE_DIE);
+	}
+	g->framedelay = (g->framedelay + 1)%3;
+	if(g->framedelay == 0) {
+		g->frame = (g->frame + 1) % 6;
+	}
+
+	// Move girds
+	Ents* e = &g->girds;
+	for( int i = 0; i < e->count; i++ ) {
+		e->y[i] = fxAddSat(e->y[i], g->gird_accel);
+		if(e->y[i] > inttofx20(384)) {
+			e->y[i] = 0;
+			e->x[i] = inttofx20(gameRand(g) % 200);
+		}
+		collUpdate(&g->gird_bands, i, fx20toint(e->y[i]));
+	}
+	g->gird_step = g->gird_accel;
+	g->gird_accel = fxAddSat(g->gird_accel, FX20(0.001));
+
+	// Draw things on screen, front to back.
+	profBegin(PROF_SPRITES);
+	platSprite(g->x, g->y, 1, GFX_PUC, g->frame, g->nose_right);
+
+	drawGirds(g);
+
+	drawGhosts(g, false);
+	profEnd();
+}
+
+static void stepMenu(Game* g, u32 keys){
+	if( keys & GKEY_START ) {
+		g->mode = MODE_PLAY;
+	}
+
+	// Reset.
+	resetPuc(g);
+	resetGirds(g);
+
+	// Ghosties
+	moveGhosts(g);
+	profBegin(PROF_SPRITES);
+	drawGhosts(g, true);
+	profEnd();
+}
+
+void gameInit(Game* g, u32 seed){
+	if( !ghost_waves_done ) {
+		oscWaveInit(ghost_wave4, 4);
+		oscWaveInit(ghost_wave5, 5);
+		oscWaveInit(ghost_wave10, 10);
+		ghost_waves_done = true;
+	}
+
+	g->mode = MODE_MENU;
+	g->rng = seed ^ 0x9E3779B9;
+	if( g->rng == 0 ) {
+		g->rng = 1;
+	}
+	resetPuc(g);
+	g->girds.count = 0;
+	collClear(&g->gird_bands);
+	for( int i = 0; i < GIRDS; i++ ) {
+		collAdd(&g->gird_bands, entSpawn(&g->girds), 0);
+	}
+	resetGirds(g);
+
+	g->ghosts.count = 0;
+	spawnGhosts(g);
+
+	// whole-row bobbing, sin(t*2.0)*5 and cos(t*2.3)*5 with t += 0.05 per frame
+	g->ghost_bob_a = (OscBank){ ghost_wave5, 0, OSC_RAD(0.1) };
+	g->ghost_bob_b = (OscBank){ ghost_wave5, OSC_QUARTER, OSC_RAD(0.115) };
+
+	platBackground(BG_MENU);
+	platCue(CUE_MUSIC);
+}
+
+// The background for a new mode goes up after the frame that switched,
+// like it did when each mode had its own loop.
+void gameStep(Game* g, u32 keys){
+	int mode = g->mode;
+
+	profBegin(PROF_GAME);
+	if( mode == MODE_PLAY ) {
+		stepPlay(g, keys);
+	}
+	else {
+		stepMenu(g, keys);
+	}
+
+	if( g->mode != mode ) {
+		platBackground(g->mode == MODE_PLAY ? BG_GAME : BG_MENU);
+	}
+	profEnd();
+}
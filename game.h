@@ -0,0 +1,74 @@
+//
+//  game.h : The game itself, without any hardware.
+//
+/* === NOTES ===
+	gameStep() runs one frame: input in, sprites, background and cues
+	out through platform.h. It never waits; the platform loop does:
+
+		gameInit(&game, seed);
+		for(;;) {
+			gameStep(&game, keys());
+			wait for the frame and show it
+		}
+
+	A Game holds no pointers into itself, so it can be copied to save
+	and restore a state. All its randomness comes from the seed, so the
+	same seed and keys give the same frames anywhere; see replay.h.
+*/
+
+#ifndef __GAME_H__
+#define __GAME_H__
+
+#include "types.h"
+#include "fixed.h"
+#include "osc.h"
+#include "ents.h"
+#include "coll.h"
+
+// Keys, with the DS keypad's bits so keysHeld() can go in as it is.
+#define GKEY_A			(1<<0)
+#define GKEY_START		(1<<3)
+#define GKEY_RIGHT		(1<<4)
+#define GKEY_LEFT		(1<<5)
+
+// spawned by gameInit()
+#define GIRDS			4
+#define GHOSTS			20		// per row
+
+enum
+{
+	MODE_PLAY,
+	MODE_MENU,
+};
+
+typedef struct Game
+{
+	int mode;
+	u32 rng;
+
+	// puc
+	int x, y;
+	int prev_y;			// y when landing was last checked
+	bool nose_right;
+	bool grounded;
+	fx12 acc_x;
+	fx20 acc_y;
+	int frame;
+	int framedelay;
+
+	// girders, all falling at gird_accel
+	Ents girds;
+	fx20 gird_accel;
+	fx20 gird_step;		// how far they fell last frame
+	CollBands gird_bands;	// kept in step with girds, see coll.h
+
+	// ghosties; the banks point at waves shared by all games
+	Ents ghosts;
+	OscBank ghost_bob_a;
+	OscBank ghost_bob_b;
+} Game;
+
+void gameInit(Game* g, u32 seed);
+void gameStep(Game* g, u32 keys);
+
+#endif // __GAME_H__
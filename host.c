@@ -0,0 +1,248 @@
+//
+//  host.c : Headless platform for running the game core on a PC.
+//
+/* === NOTES ===
+	No graphics and no sound: sprites go into the same shadow OAM as on
+	the DS, and every few frames it is folded into a checksum so two
+	builds (or two versions of game.c) can be compared. The keys are random but
+	reproducible, and START is pressed in the menu so most frames are
+	actual play. Or they come from a replay, which gives the same
+	checksum as the run that recorded it.
+
+	The same profiler sections as on the DS are timed with the host's
+	clock, minus the VBlank wait; the table at the end is the last
+	PROF_FRAMES frames.
+
+	It also reports the per line sprite cost sprEnd() works out (see
+	sprites.h): the worst line against the budget, and how often the
+	flicker scheduler had to leave sprites out.
+
+	Usage: headless [-record file | -play file] [frames [seed]]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.h"
+#include "platform.h"
+#include "prof.h"
+#include "replay.h"
+#include "sprites.h"
+
+// Frames between checksums; hashing all 256 sprites costs more than a frame.
+#define HASH_EVERY	16
+
+static SprOam spr[2];
+static u32 bg_changes, cues[3];
+static u64 committed;
+static u32 over_frames, over_lines, flickered;
+static int peak;
+
+// Any tile layout will do, as long as the gfx don't overlap.
+void platSprite(int x, int y, int prio, int gfx, int frame, bool hflip)
+{
+	int tile[2]= { gfx*64 + frame*8, gfx*64 + frame*8 };
+	sprAddWorld(spr, x, y, prio, tile, hflip);
+}
+
+//! What the DS's VBlank handler does, minus the copy.
+static void commit()
+{
+	int i, first;
+
+	profBegin(PROF_SPRITES);
+	for(i=0; i<2; i++)
+		sprEnd(&spr[i]);
+	profEnd();
+
+	profBegin(PROF_OAM);
+	for(i=0; i<2; i++)
+	{
+		over_frames += spr[i].over > 0;
+		over_lines += spr[i].over;
+		flickered += spr[i].flickered;
+		if(spr[i].peak > peak)
+			peak= spr[i].peak;
+		committed += sprDirtySpan(&spr[i], &first);
+		sprClean(&spr[i]);
+		sprBegin(&spr[i]);
+	}
+	profEnd();
+	profFrame();
+}
+
+void platBackground(int bg)
+{
+	bg_changes++;
+}
+
+void platCue(int cue)
+{
+	cues[cue]++;
+}
+
+//! FNV-1a style, a word at a time, over both screens' OAM.
+static u32 frameHash(u32 h)
+{
+	u32 w[SPR_COUNT*4];
+	size_t i;
+
+	memcpy(w, spr[0].oam, sizeof(spr[0].oam));
+	memcpy(w+SPR_COUNT*2, spr[1].oam, sizeof(spr[1].oam));
+	for(i=0; i<SPR_COUNT*4; i++)
+		h= (h ^ w[i]) * 16777619u;
+	return h;
+}
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+//! ns, wrapping every 4 seconds or so.
+u32 platTicks(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000u + ts.tv_nsec;
+}
+
+//! Reads a whole file into a malloc'd buffer.
+static u8 *loadFile(const char *path, u32 *size)
+{
+	FILE *fp= fopen(path, "rb");
+	u8 *buf;
+	long len;
+
+	if(fp == NULL)
+		return NULL;
+	fseek(fp, 0, SEEK_END);
+	len= ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	buf= malloc(len > 0 ? len : 1);
+	if(buf && fread(buf, 1, len, fp) != (size_t)len)
+	{
+		free(buf);
+		buf= NULL;
+	}
+	fclose(fp);
+	*size= len;
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *recPath= NULL, *playPath= NULL;
+	u32 frames= 10000000, seed= 1;
+	u32 i, keys= 0, lcg, hash= 2166136261u, played= 0;
+	u8 *buf= NULL;
+	static Game game;
+	Replay rep;
+	double t0, ns;
+
+	if(argc>2 && strcmp(argv[1], "-record") == 0)
+		recPath= argv[2], argv += 2, argc -= 2;
+	else if(argc>2 && strcmp(argv[1], "-play") == 0)
+		playPath= argv[2], argv += 2, argc -= 2;
+	if(argc>1)
+		frames= strtoul(argv[1], NULL, 0);
+	if(argc>2)
+		seed= strtoul(argv[2], NULL, 0);
+
+	if(playPath)
+	{
+		u32 size;
+		buf= loadFile(playPath, &size);
+		if(buf == NULL || !replayPlayBegin(&rep, buf, size))
+		{
+			fprintf(stderr, "%s: not a replay\n", playPath);
+			return 1;
+		}
+		frames= rep.frames;
+		seed= rep.seed;
+	}
+	else if(recPath)
+	{
+		// Keys change every 8 frames at most, so this is plenty.
+		buf= malloc(frames + 64);
+		replayRecordBegin(&rep, buf, frames + 64, seed);
+	}
+
+	profInit(1000000000);
+	sprInit(&spr[0]);
+	sprInit(&spr[1]);
+	spr[0].flicker= spr[1].flicker= true;
+	gameInit(&game, seed);
+	commit();
+	committed= 0;
+	lcg= seed;
+
+	t0= nsNow();
+	for(i=0; i<frames; i++)
+	{
+		profBegin(PROF_INPUT);
+		if(playPath)
+		{
+			if(!replayPlay(&rep, &keys))
+			{
+				fprintf(stderr, "%s: ends after %u frames\n", playPath, i);
+				frames= i;
+				profEnd();
+				break;
+			}
+		}
+		// Hold a random direction and A for a few frames at a time.
+		else if((i & 7) == 0)
+		{
+			lcg= lcg*1664525 + 1013904223;
+			keys= (lcg>>24) & (GKEY_A | GKEY_RIGHT | GKEY_LEFT);
+			if(game.mode == MODE_MENU)
+				keys |= GKEY_START;
+		}
+		if(recPath)
+			replayRecord(&rep, keys);
+		profEnd();
+		played += game.mode == MODE_PLAY;
+		gameStep(&game, keys);
+		commit();
+		if(i % HASH_EVERY == 0)
+			hash= frameHash(hash);
+	}
+	ns= nsNow()-t0;
+
+	if(recPath)
+	{
+		u32 size= replayRecordEnd(&rep);
+		FILE *fp= fopen(recPath, "wb");
+		if(fp == NULL || fwrite(buf, 1, size, fp) != size)
+		{
+			fprintf(stderr, "%s: can't write\n", recPath);
+			return 1;
+		}
+		fclose(fp);
+		printf("recorded %u frames in %u bytes\n", rep.frames, size);
+	}
+	free(buf);
+
+	printf("%u frames (%u played), %u deaths, %u jumps, %u background changes\n",
+		frames, played, cues[CUE_DIE], cues[CUE_JUMP], bg_changes);
+	printf("sprite checksum %08x\n", hash);
+	printf("OAM entries written: %.1f per frame, of %d\n", (double)committed/frames, SPR_COUNT*2);
+	printf("sprite cycles per line: peak %d of %d, %u screen frames and %u lines over, %u sprites flickered\n",
+		peak, SPR_LINE_CYCLES, over_frames, over_lines, flickered);
+	printf("%.1f ns per frame, %.2f M frames/s\n", ns/frames, frames/ns*1e3);
+
+	printf("%-8s %8s %8s %8s  ns, last %d frames\n", "section", "min", "avg", "max", profFrames());
+	for(i=0; i<PROF_SECTIONS; i++)
+	{
+		ProfStats st;
+		profStats(i, &st);
+		printf("%-8s %8u %8u %8u\n", profName(i), st.min, st.avg, st.max);
+	}
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <string.h>
+
+#include "lz77.h"
+
+void lzDecompress(const void* src, void* dst){
+	const u8* s = (const u8*)src + 4;
+	u8* d = dst;
+	u8* end = d + lzSize(src);
+
+	while( d < end ) {
+		u32 flags = *s++;
+		if( flags == 0 && end - d >= 8 ) {
+			memcpy(d, s, 8);
+			d += 8;
+			s += 8;
+			continue;
+		}
+		for( int i = 0; i < 8 && d < end; i++, flags <<= 1 ) {
+			if( flags & 0x80 ) {
+				u32 b = s[0]<<8 | s[1];
+				const u8* r = d - (b & 0xFFF) - 1;
+				u32 len = (b>>12) + 3;
+				s += 2;
+				if( len > end - d ) {
+					len = end - d;
+				}
+				while( len-- ) {
+					*d++ = *r++;
+				}
+			}
+			else {
+				*d++ = *s++;
+			}
+		}
+	}
+}
+
+// Literals and references go two bytes a halfword once pos is even;
+// only the first byte of a pair can still be waiting in odd.
+void lzDecompressVram(const void* src, void* dst){
+	const u8* s = (const u8*)src + 4;
+	u16* out = dst;
+	const u8* in = dst;
+	u32 size = lzSize(src);
+	u32 pos = 0;
+	u32 odd = 0;		// the byte waiting when pos is odd
+
+	while( pos < size ) {
+		u32 flags = *s++;
+		if( flags == 0 && size - pos >= 8 ) {
+			u16* o = &out[pos>>1];
+			if( pos & 1 ) {
+				o[0] = odd | s[0]<<8;
+				o[1] = s[1] | s[2]<<8;
+				o[2] = s[3] | s[4]<<8;
+				o[3] = s[5] | s[6]<<8;
+				odd = s[7];
+			}
+			else {
+				o[0] = s[0] | s[1]<<8;
+				o[1] = s[2] | s[3]<<8;
+				o[2] = s[4] | s[5]<<8;
+				o[3] = s[6] | s[7]<<8;
+			}
+			pos += 8;
+			s += 8;
+			continue;
+		}
+		for( int i = 0; i < 8 && pos < size; i++, flags <<= 1 ) {
+			if( !(flags & 0x80) ) {
+				if( pos & 1 ) {
+					out[pos>>1] = odd | *s++ << 8;
+				}
+				else {
+					odd = *s++;
+				}
+				pos++;
+				continue;
+			}
+
+			u32 b = s[0]<<8 | s[1];
+			u32 dist = (b & 0xFFF) + 1;
+			u32 len = (b>>12) + 3;
+			s += 2;
+			if( len > size - pos ) {
+				len = size - pos;
+			}
+			if( pos & 1 ) {
+				u32 c = dist == 1 ? odd : in[pos - dist];
+				out[pos>>1] = odd | c<<8;
+				pos++;
+				len--;
+			}
+			for( ; len >= 2; len -= 2, pos += 2 ) {
+				u32 c0 = in[pos - dist];
+				u32 c1 = dist == 1 ? c0 : in[pos+1 - dist];
+				out[pos>>1] = c0 | c1<<8;
+			}
+			if( len ) {
+				odd = in[pos - dist];
+				pos++;
+			}
+		}
+	}
+	if( pos & 1 ) {
+		out[pos>>1] = odd;
+	}
+}
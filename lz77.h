@@ -0,0 +1,36 @@
+//
+//  lz77.h : Decoding the BIOS LZ77 format, as grit -gzl writes it.
+//
+/* === NOTES ===
+	The stream is a header word, 0x10 | size<<8, then groups of a flag
+	byte and 8 blocks, flags from the top bit down. A 0 is a literal
+	byte; a 1 is two bytes, len-3 in the top nibble and dist-1 in the
+	other 12 bits, copying len bytes from dist back.
+
+	lzDecompress() writes bytes, so it is for main RAM.
+	lzDecompressVram() only writes halfwords, as VRAM needs; an odd
+	byte waits for its partner, and a reference to it is read from
+	there. That is the job of the BIOS's swiDecompressLZSSVram(), minus
+	the callbacks where that one loses its time. Both take a group with
+	no references as 8 literals in one go, which image data with any
+	noise in it has a lot of.
+
+	Both are built in ARM mode on the DS. lzSize() is the unpacked size.
+	lzbench times them against a plain decoder on the host.
+*/
+
+#ifndef __LZ77_H__
+#define __LZ77_H__
+
+#include "types.h"
+
+static inline u32 lzSize(const void* src)
+{
+	const u8* s = src;
+	return s[1] | s[2]<<8 | s[3]<<16;
+}
+
+void lzDecompress(const void* src, void* dst);
+void lzDecompressVram(const void* src, void* dst);
+
+#endif // __LZ77_H__
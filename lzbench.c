@@ -0,0 +1,205 @@
+//
+//  lzbench.c : Host timing of the LZ77 decoders against each other.
+//
+/* === NOTES ===
+	Packs some data the way grit -gzl does (greedy, VRAM safe, so no
+	references to the byte just before) and times unpacking it with a
+	plain byte at a time decoder, which is what the BIOS does minus its
+	callbacks, and with lz77.c's two. A memcpy of the unpacked data is
+	there for scale. Each result is checked against the original.
+
+	Without files it uses a made up 256x256 8 bit picture: smooth
+	gradients with some noise, like the backgrounds.
+
+	Usage: lzbench [file ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lz77.h"
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+//! Greedy LZ77 in the BIOS format; returns the packed size.
+static u32 pack(const u8 *src, u32 size, u8 *dst)
+{
+	u32 pos= 0, out= 4;
+
+	dst[0]= 0x10;
+	dst[1]= size;
+	dst[2]= size>>8;
+	dst[3]= size>>16;
+	while(pos < size)
+	{
+		u32 flagAt= out++, i;
+		dst[flagAt]= 0;
+		for(i=0; i<8 && pos<size; i++)
+		{
+			u32 best= 0, bestDist= 0, dist;
+			for(dist=2; dist<=4096 && dist<=pos; dist++)
+			{
+				u32 len= 0;
+				while(len < 18 && pos+len < size && src[pos+len] == src[pos+len-dist])
+					len++;
+				if(len > best)
+				{
+					best= len;
+					bestDist= dist;
+					if(len == 18)
+						break;
+				}
+			}
+			if(best >= 3)
+			{
+				dst[flagAt] |= 0x80>>i;
+				dst[out++]= (best-3)<<4 | (bestDist-1)>>8;
+				dst[out++]= bestDist-1;
+				pos += best;
+			}
+			else
+				dst[out++]= src[pos++];
+		}
+	}
+	return (out+3) & ~3;
+}
+
+//! One block at a time, one byte at a time.
+static void unpackPlain(const void *src, void *dst)
+{
+	const u8 *s= (const u8*)src + 4;
+	u8 *d= dst;
+	u32 size= lzSize(src), pos= 0, flags= 0, n= 0;
+
+	while(pos < size)
+	{
+		if(n-- == 0)
+		{
+			flags= *s++;
+			n= 7;
+		}
+		if(flags & 0x80)
+		{
+			u32 b= s[0]<<8 | s[1], len= (b>>12) + 3, dist= (b & 0xFFF) + 1;
+			s += 2;
+			while(len-- && pos < size)
+			{
+				d[pos]= d[pos-dist];
+				pos++;
+			}
+		}
+		else
+			d[pos++]= *s++;
+		flags <<= 1;
+	}
+}
+
+static u8 *loadFile(const char *path, u32 *size)
+{
+	FILE *fp= fopen(path, "rb");
+	u8 *buf;
+	long len;
+
+	if(fp == NULL)
+		return NULL;
+	fseek(fp, 0, SEEK_END);
+	len= ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	buf= malloc(len > 0 ? len : 1);
+	if(buf && fread(buf, 1, len, fp) != (size_t)len)
+	{
+		free(buf);
+		buf= NULL;
+	}
+	fclose(fp);
+	*size= len;
+	return buf;
+}
+
+static u8 *madeUp(u32 *size)
+{
+	u8 *buf= malloc(256*256);
+	u32 lcg= 1, x, y;
+
+	for(y=0; y<256; y++)
+		for(x=0; x<256; x++)
+		{
+			lcg= lcg*1664525 + 1013904223;
+			buf[y*256+x]= (x/16 + y/32) + ((lcg>>28) == 0 ? lcg>>24 & 3 : 0);
+		}
+	*size= 256*256;
+	return buf;
+}
+
+typedef void (*Unpack)(const void *src, void *dst);
+
+static double timeIt(Unpack fn, const void *src, u8 *dst, u32 size, const u8 *want, int *bad)
+{
+	int reps= 1 + (int)(4000000/(size+1)), i;
+	double t0;
+
+	fn(src, dst);
+	*bad |= memcmp(dst, want, size) != 0;
+	t0= nsNow();
+	for(i=0; i<reps; i++)
+		fn(src, dst);
+	return (nsNow()-t0)/reps;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct { const char *name; Unpack fn; } fns[]=
+	{
+		{ "plain",	unpackPlain },
+		{ "lz",		lzDecompress },
+		{ "vram",	lzDecompressVram },
+	};
+	int a, i, nFiles= argc>1 ? argc-1 : 1;
+
+	printf("%-20s %7s %7s %9s %9s %9s %9s\n", "data", "bytes", "packed",
+		"memcpy us", "plain us", "lz us", "vram us");
+	for(a=0; a<nFiles; a++)
+	{
+		u32 size;
+		u8 *raw= argc>1 ? loadFile(argv[a+1], &size) : madeUp(&size);
+		u8 *packed, *dst;
+		u32 packedSize;
+		double ns;
+		int bad= 0;
+
+		if(raw == NULL)
+		{
+			fprintf(stderr, "%s: can't read\n", argv[a+1]);
+			return 1;
+		}
+		packed= malloc(size + size/8 + 16);
+		dst= malloc(size + 2);
+		packedSize= pack(raw, size, packed);
+
+		printf("%-20s %7u %7u", argc>1 ? argv[a+1] : "(made up)", size, packedSize);
+		{
+			int reps= 1 + (int)(4000000/(size+1)), r;
+			double t0= nsNow();
+			for(r=0; r<reps; r++)
+				memcpy(dst, raw, size);
+			ns= (nsNow()-t0)/reps;
+		}
+		printf(" %9.1f", ns/1000);
+		for(i=0; i<3; i++)
+			printf(" %9.1f", timeIt(fns[i].fn, packed, dst, size, raw, &bad)/1000);
+		printf("%s\n", bad ? "  MISMATCH" : "");
+		free(raw);
+		free(packed);
+		free(dst);
+		if(bad)
+			return 1;
+	}
+	return 0;
+}
@@ -26,6 +26,7 @@ long freqs[9] = { 44100, 48000, 32000,
 
 int bitindex;
 unsigned char *wordpointer;
+unsigned char *wordend; /* end of the current frame */
 unsigned char *pcm_sample;
 int pcm_point = 0;
 
@@ -81,6 +82,9 @@ int head_check(unsigned long head)
  */
 int decode_header(struct frame *fr,unsigned long newhead)
 {
+    if( (newhead & 0xffe00000) != 0xffe00000)
+      return (0);
+
     if( newhead & (1<<20) ) {
       fr->lsf = (newhead & (1<<19)) ? 0x0 : 0x1;
       fr->mpeg25 = 0;
@@ -93,7 +97,7 @@ int decode_header(struct frame *fr,unsigned long newhead)
     fr->lay = 4-((newhead>>17)&3);
     if( ((newhead>>10)&0x3) == 0x3) {
       fprintf(stderr,"Stream error\n");
-      exit(1);
+      return (0);
     }
     if(fr->mpeg25) {
       fr->sampling_frequency = 6 + ((newhead>>10)&0x3);
@@ -121,6 +125,11 @@ int decode_header(struct frame *fr,unsigned long newhead)
       fprintf(stderr,"Free format not supported.\n");
       return (0);
     }
+    if(fr->bitrate_index == 0xf)
+    {
+      fprintf(stderr,"Stream error\n");
+      return (0);
+    }
 
     switch(fr->lay)
     {
@@ -134,6 +143,7 @@ int decode_header(struct frame *fr,unsigned long newhead)
         fr->framesize  = ((fr->framesize+fr->padding)<<2)-4;
 #else
         fprintf(stderr,"Not supported!\n");
+        return (0);
 #endif
         break;
       case 2:
@@ -147,6 +157,7 @@ int decode_header(struct frame *fr,unsigned long newhead)
         fr->framesize += fr->padding - 4;
 #else
         fprintf(stderr,"Not supported!\n");
+        return (0);
 #endif
         break;
       case 3:
@@ -165,6 +176,10 @@ int decode_header(struct frame *fr,unsigned long newhead)
           fr->framesize  = (long) tabsel_123[fr->lsf][2][fr->bitrate_index] * 144000;
           fr->framesize /= freqs[fr->sampling_frequency]<<(fr->lsf);
           fr->framesize = fr->framesize + fr->padding - 4;
+          if(fr->framesize > MAXFRAMESIZE) {
+            fprintf(stderr,"Frame too big.\n");
+            return (0);
+          }
         break; 
       default:
         fprintf(stderr,"Sorry, unknown layer type.\n");
@@ -251,6 +266,19 @@ unsigned int getbits_fast(int number_of_bits)
   return rval;
 }
 
+void skipbits(int number_of_bits)
+{
+  bitindex += number_of_bits;
+  wordpointer += (bitindex>>3);
+  bitindex &= 7;
+}
+
+/* bits up to the end of the frame, negative once read past it */
+int bitsleft(void)
+{
+  return ((int) (wordend - wordpointer) << 3) - bitindex;
+}
+
 unsigned int get1bit(void)
 {
   unsigned char rval;
@@ -0,0 +1,64 @@
+/* fuzz target: arbitrary bytes through decodeMP3() in every output format
+ *
+ * libFuzzer:  make mpglib-fuzz      (clang, -fsanitize=fuzzer,address)
+ * AFL/plain:  make mpglib-fuzz-afl  (reads one input from stdin)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "mpg123.h"
+#include "mpglib.h"
+
+static struct mpstr mp;
+static char out[16384];	/* > one float planar stereo frame */
+
+static const int formats[] = {
+	MP3_FMT_S16, MP3_FMT_S8, MP3_FMT_U8, MP3_FMT_FLOAT,
+	MP3_FMT_S16|MP3_FMT_PLANAR, MP3_FMT_FLOAT|MP3_FMT_PLANAR,
+	MP3_FMT_S16|MP3_DOWNMIX, MP3_FMT_S8|MP3_DOWNMIX,
+	MP3_FMT_U8|MP3_DOWNMIX, MP3_FMT_FLOAT|MP3_DOWNMIX
+};
+
+static void decode_all(const uint8_t *data,size_t size,int format)
+{
+	size_t pos,chunk;
+	int ret,done;
+
+	if(size < 1)
+		return;
+	/* first byte picks the chunk size, so headers and frames get split
+	   across calls at different offsets */
+	chunk = 1 + data[0] % 64 * 16;
+	data++; size--;
+
+	InitMP3Format(&mp,format);
+	for(pos = 0; pos < size; pos += chunk) {
+		int len = size-pos < chunk ? size-pos : chunk;
+		ret = decodeMP3(&mp,(char *) data+pos,len,out,sizeof(out),&done);
+		while(ret == MP3_OK)
+			ret = decodeMP3(&mp,NULL,0,out,sizeof(out),&done);
+	}
+	ExitMP3(&mp);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data,size_t size)
+{
+	int i;
+
+	for(i = 0; i < (int) (sizeof(formats)/sizeof(formats[0])); i++)
+		decode_all(data,size,formats[i]);
+	return 0;
+}
+
+#ifdef MP3_FUZZ_MAIN
+static uint8_t in[1<<20];
+
+int main(void)
+{
+	size_t size = fread(in,1,sizeof(in),stdin);
+
+	return LLVMFuzzerTestOneInput(in,size);
+}
+#endif
@@ -5,11 +5,16 @@
 #include "mpg123.h"
 #include "mpglib.h"
 
-/* Global mp .. it's a hack */
-struct mpstr *gmp;
+/* Global mp .. it's a hack (one per thread, the stages set it on entry) */
+MP3_TLS struct mpstr *gmp;
 
 
 BOOL InitMP3(struct mpstr *mp) 
+{
+	return InitMP3Format(mp,MP3_FMT_S16);
+}
+
+BOOL InitMP3Format(struct mpstr *mp,int format)
 {
 	memset(mp,0,sizeof(struct mpstr));
 
@@ -17,9 +22,34 @@ BOOL InitMP3(struct mpstr *mp)
 	mp->fsizeold = -1;
 	mp->bsize = 0;
 	mp->head = mp->tail = NULL;
-	mp->fr.single = -1;
+	mp->fr.single = (format & MP3_DOWNMIX) ? 3 : -1;
 	mp->bsnum = 0;
 	mp->synth_bo = 1;
+	mp->outfmt = format;
+
+	switch(format & MP3_FMT_MASK) {
+	case MP3_FMT_S16:
+		mp->samplesize = sizeof(short);
+		mp->synth = synth_1to1;
+		mp->synth_planar = synth_1to1_planar;
+		break;
+	case MP3_FMT_S8:
+	case MP3_FMT_U8:
+		mp->samplesize = 1;
+		mp->synth = synth_1to1_8bit;
+		mp->synth_planar = synth_1to1_8bit_planar;
+		make_conv16to8_table();
+		mp->conv16to8 = conv16to8[(format & MP3_FMT_MASK) == MP3_FMT_U8];
+		break;
+	case MP3_FMT_FLOAT:
+		mp->samplesize = sizeof(float);
+		mp->synth = synth_1to1_float;
+		mp->synth_planar = synth_1to1_float_planar;
+		break;
+	default:
+		fprintf(stderr,"Unknown output format %d\n",format);
+		return 0;
+	}
 
 	make_decode_tables(32767);
 	init_layer3(SBLIMIT);
@@ -40,6 +70,13 @@ void ExitMP3(struct mpstr *mp)
 	}
 }
 
+#ifdef MP3_STATS
+void GetMP3Stats(struct mpstr *mp,struct mp3stats *stats)
+{
+	*stats = mp->stats;
+}
+#endif
+
 static struct buf *addbuf(struct mpstr *mp,char *buf,int size)
 {
 	struct buf *nbuf;
@@ -98,11 +135,11 @@ static int read_buf_byte(struct mpstr *mp)
 	pos = mp->tail->pos;
 	while(pos >= mp->tail->size) {
 		remove_buf(mp);
-		pos = mp->tail->pos;
 		if(!mp->tail) {
 			fprintf(stderr,"Fatal error!\n");
-			exit(1);
+			return 0;
 		}
+		pos = mp->tail->pos;
 	}
 
 	b = mp->tail->pnt[pos];
@@ -128,18 +165,17 @@ static void read_head(struct mpstr *mp)
 	mp->header = head;
 }
 
-int decodeMP3(struct mpstr *mp,char *in,int isize,char *out,
-		int osize,int *done)
+/*
+ * Bitstream stage: takes in the next frame and queues its dequantised
+ * granules for decodeMP3_synth(). MP3_QUEUE_FULL leaves the frame in the
+ * input buffers, call again (with in == NULL) once the synth caught up.
+ */
+int decodeMP3_parse(struct mpstr *mp,char *in,int isize)
 {
 	int len;
 
 	gmp = mp;
 
-	if(osize < 4608) {
-		fprintf(stderr,"To less out space\n");
-		return MP3_ERR;
-	}
-
 	if(in) {
 		if(addbuf(mp,in,isize) == NULL) {
 			return MP3_ERR;
@@ -148,18 +184,33 @@ int decodeMP3(struct mpstr *mp,char *in,int isize,char *out,
 
 	/* First decode header */
 	if(mp->framesize == 0) {
-		if(mp->bsize < 4) {
-			return MP3_NEED_MORE;
+		if(!mp->resyncing) {
+			if(mp->bsize < 4) {
+				return MP3_NEED_MORE;
+			}
+			read_head(mp);
+			mp->resyncing = 1;
 		}
-		read_head(mp);
-		decode_header(&mp->fr,mp->header);
+		/* not a layer 3 header we can handle: resync byte by byte,
+		   across calls, so a sync word split between chunks is found */
+		while(!decode_header(&mp->fr,mp->header)) {
+			if(mp->bsize < 1)
+				return MP3_NEED_MORE;
+			mp->header = ((mp->header << 8) | read_buf_byte(mp)) & 0xffffffff;
+		}
+		mp->resyncing = 0;
 		mp->framesize = mp->fr.framesize;
 	}
 
 	if(mp->fr.framesize > mp->bsize)
 		return MP3_NEED_MORE;
 
+	if(MP3_QUEUE_LEN - (mp->queue.head - mp->queue.tail) < (mp->fr.lsf ? 1 : 2))
+		return MP3_QUEUE_FULL;
+	MP3_BARRIER(); /* the synth is done with the slots it gave back */
+
 	wordpointer = mp->bsspace[mp->bsnum] + 512;
+	wordend = wordpointer + mp->framesize;
 	mp->bsnum = (mp->bsnum + 1) & 0x1;
 	bitindex = 0;
 
@@ -182,10 +233,10 @@ int decodeMP3(struct mpstr *mp,char *in,int isize,char *out,
                 }
 	}
 
-	*done = 0;
 	if(mp->fr.error_protection)
            getbits(16);
-	do_layer3(&mp->fr,(unsigned char *) out,done);
+	do_layer3(&mp->fr);
+	STAT_ADD(frames,1);
 
 	mp->fsizeold = mp->framesize;
 	mp->framesize = 0;
@@ -193,6 +244,49 @@ int decodeMP3(struct mpstr *mp,char *in,int isize,char *out,
 	return MP3_OK;
 }
 
+/*
+ * Synthesis stage: writes the PCM of the oldest queued frame to out,
+ * MP3_NEED_MORE if decodeMP3_parse() has not queued one yet.
+ */
+int decodeMP3_synth(struct mpstr *mp,char *out,int osize,int *done)
+{
+	gmp = mp;
+
+	if(osize < 1152 * 2 * mp->samplesize) {
+		fprintf(stderr,"To less out space\n");
+		return MP3_ERR;
+	}
+
+	*done = 0;
+	if(mp->queue.head == mp->queue.tail)
+		return MP3_NEED_MORE;
+	MP3_BARRIER();
+
+	STAT_ADD(clipped,synth_layer3((unsigned char *) out,done));
+
+	return MP3_OK;
+}
+
+int decodeMP3(struct mpstr *mp,char *in,int isize,char *out,
+		int osize,int *done)
+{
+	int ret;
+
+	if(osize < 1152 * 2 * mp->samplesize) {
+		fprintf(stderr,"To less out space\n");
+		return MP3_ERR;
+	}
+
+	ret = decodeMP3_parse(mp,in,isize);
+	if(ret != MP3_OK)
+		return ret;
+
+	/* a frame broken in its first granule queues nothing, *done is 0 then */
+	decodeMP3_synth(mp,out,osize,done);
+
+	return MP3_OK;
+}
+
 int set_pointer(long backstep)
 {
   unsigned char *bsbufold;
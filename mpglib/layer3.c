@@ -10,7 +10,7 @@
 #include "mpglib.h"
 #include "huffman.h"
 
-extern struct mpstr *gmp;
+extern MP3_TLS struct mpstr *gmp;
 
 #define MPEG1
 
@@ -20,7 +20,7 @@ static real aa_ca[8],aa_cs[8];
 static real COS1[12][6];
 static real win[4][36];
 static real win1[4][36];
-static real gainpow2[256+118+4];
+static real gainpow2[256+118+8];
 static real COS9[9];
 static real COS6_1,COS6_2;
 static real tfcos36[9];
@@ -103,7 +103,7 @@ void init_layer3(int down_sample_sblimit)
 {
   int i,j,k,l;
 
-  for(i=-256;i<118+4;i++)
+  for(i=-256;i<118+8;i++)
     gainpow2[i+256] = pow((double)2.0,-0.25 * (double) (i+210) );
 
   for(i=0;i<8207;i++)
@@ -190,7 +190,9 @@ void init_layer3(int down_sample_sblimit)
 
    mp = map[j][0] = mapbuf0[j];
    bdf = bi->longDiff;
-   for(i=0,cb = 0; cb < 8 ; cb++,i+=*bdf++) {
+   /* the long part of a mixed block is the first two subbands (36 lines),
+      8 bands at MPEG 1 rates but fewer at the MPEG 2/2.5 ones */
+   for(i=0,cb = 0; cb < 8 && i < 36 ; cb++,i+=*bdf++) {
      *mp++ = (*bdf) >> 1;
      *mp++ = i;
      *mp++ = 3;
@@ -294,7 +296,7 @@ void init_layer3(int down_sample_sblimit)
  * read additional side information
  */
 #ifdef MPEG1 
-static void III_get_side_info_1(struct III_sideinfo *si,int stereo,
+static int III_get_side_info_1(struct III_sideinfo *si,int stereo,
  int ms_stereo,long sfreq,int single)
 {
    int ch, gr;
@@ -345,7 +347,7 @@ static void III_get_side_info_1(struct III_sideinfo *si,int stereo,
 
          if(gr_info->block_type == 0) {
            fprintf(stderr,"Blocktype == 0 and window-switching == 1 not allowed.\n");
-           exit(1);
+           return MP3_ERR;
          }
          /* region_count/start parameters are implicit in this case. */       
          gr_info->region1start = 36>>1;
@@ -359,7 +361,10 @@ static void III_get_side_info_1(struct III_sideinfo *si,int stereo,
          r0c = getbits_fast(4);
          r1c = getbits_fast(3);
          gr_info->region1start = bandInfo[sfreq].longIdx[r0c+1] >> 1 ;
-         gr_info->region2start = bandInfo[sfreq].longIdx[r0c+1+r1c+1] >> 1;
+         if(r0c+1+r1c+1 > 22)
+           gr_info->region2start = 576>>1;
+         else
+           gr_info->region2start = bandInfo[sfreq].longIdx[r0c+1+r1c+1] >> 1;
          gr_info->block_type = 0;
          gr_info->mixed_block_flag = 0;
        }
@@ -368,13 +373,14 @@ static void III_get_side_info_1(struct III_sideinfo *si,int stereo,
        gr_info->count1table_select = get1bit();
      }
    }
+   return MP3_OK;
 }
 #endif
 
 /*
  * Side Info for MPEG 2.0 / LSF
  */
-static void III_get_side_info_2(struct III_sideinfo *si,int stereo,
+static int III_get_side_info_2(struct III_sideinfo *si,int stereo,
  int ms_stereo,long sfreq,int single)
 {
    int ch;
@@ -418,7 +424,7 @@ static void III_get_side_info_2(struct III_sideinfo *si,int stereo,
 
          if(gr_info->block_type == 0) {
            fprintf(stderr,"Blocktype == 0 and window-switching == 1 not allowed.\n");
-           exit(1);
+           return MP3_ERR;
          }
          /* region_count/start parameters are implicit in this case. */       
 /* check this again! */
@@ -439,13 +445,17 @@ static void III_get_side_info_2(struct III_sideinfo *si,int stereo,
          r0c = getbits_fast(4);
          r1c = getbits_fast(3);
          gr_info->region1start = bandInfo[sfreq].longIdx[r0c+1] >> 1 ;
-         gr_info->region2start = bandInfo[sfreq].longIdx[r0c+1+r1c+1] >> 1;
+         if(r0c+1+r1c+1 > 22)
+           gr_info->region2start = 576>>1;
+         else
+           gr_info->region2start = bandInfo[sfreq].longIdx[r0c+1+r1c+1] >> 1;
          gr_info->block_type = 0;
          gr_info->mixed_block_flag = 0;
        }
        gr_info->scalefac_scale = get1bit();
        gr_info->count1table_select = get1bit();
    }
+   return MP3_OK;
 }
 
 /*
@@ -949,6 +959,12 @@ static int III_dequantize_sample(real xr[SBLIMIT][SSLIMIT],int *scf,
     gr_info->maxb = longLimit[sfreq][gr_info->maxbandl];
   }
 
+  STAT_ADD(huffbits,gr_info->part2_3_length - part2bits - part2remain);
+  if(part2remain > 0) {
+    STAT_ADD(underruns,1);
+    STAT_ADD(stuffbits,part2remain);
+  }
+
   while( part2remain > 16 ) {
     getbits(16); /* Dismiss stuffing Bits */
     part2remain -= 16;
@@ -956,6 +972,7 @@ static int III_dequantize_sample(real xr[SBLIMIT][SSLIMIT],int *scf,
   if(part2remain > 0)
     getbits(part2remain);
   else if(part2remain < 0) {
+    STAT_ADD(overruns,1);
     fprintf(stderr,"mpg123: Can't rewind stream by %d bits!\n",-part2remain);
     return 1; /* -> error */
   }
@@ -1506,7 +1523,7 @@ maybe still wrong??? (copy 12 to 13?) */
         }
 
         is_p = scalefac[20]; /* copy l-band 20 to l-band 21 */
-        if(is_p != 7)
+        if(is_p != 7 && gr_info->maxbandl <= 21) /* else idx is past the end */
         {
           int sb;
           real t1 = tab1[is_p],t2 = tab2[is_p]; 
@@ -1867,16 +1884,24 @@ static void III_hybrid(real fsIn[SBLIMIT][SSLIMIT],real tsOut[SSLIMIT][SBLIMIT],
 /*
  * main layer3 handler
  */
-int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
+/*
+ * bitstream stage: side info, scalefactors, Huffman, dequantisation and
+ * stereo processing of one frame into the granule queue. The caller
+ * makes sure there is room for all granules of the frame.
+ * Returns the number of granules queued, a broken granule ends the frame.
+ */
+int do_layer3(struct frame *fr)
 {
-  int gr, ch, ss,clip=0;
+  int gr, ch;
   int scalefacs[39]; /* max 39 for short[13][3] mode, mixed: 38, long: 22 */
   struct III_sideinfo sideinfo;
   int stereo = fr->stereo;
   int single = fr->single;
-  int ms_stereo,i_stereo;
+  int ms_stereo,i_stereo,mid_only;
   int sfreq = fr->sampling_frequency;
   int stereo1,granules;
+  struct mp3queue *queue = &gmp->queue;
+  unsigned int head = queue->head;
 
   if(stereo == 1) { /* stream is mono */
     stereo1 = 1;
@@ -1887,6 +1912,8 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
   else
     stereo1 = 2;
 
+  STAT_MARK(MP3_STAGE_HUFFMAN);
+
   if(fr->mode == MPG_MD_JOINT_STEREO) {
     ms_stereo = fr->mode_ext & 0x2;
     i_stereo  = fr->mode_ext & 0x1;
@@ -1894,14 +1921,23 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
   else
     ms_stereo = i_stereo = 0;
 
+  /*
+   * Downmixing M/S stereo: L+R is just the mid channel, so the side
+   * channel is skipped and mid is decoded without the 0.5 of single == 3
+   * (passing single 0 to the side info drops that powdiff).
+   */
+  mid_only = (single == 3) && ms_stereo && !i_stereo;
+
   if(fr->lsf) {
     granules = 1;
-    III_get_side_info_2(&sideinfo,stereo,ms_stereo,sfreq,single);
+    if(III_get_side_info_2(&sideinfo,stereo,ms_stereo,sfreq,mid_only ? 0 : single) == MP3_ERR)
+      return 0;
   }
   else {
     granules = 2;
 #ifdef MPEG1
-    III_get_side_info_1(&sideinfo,stereo,ms_stereo,sfreq,single);
+    if(III_get_side_info_1(&sideinfo,stereo,ms_stereo,sfreq,mid_only ? 0 : single) == MP3_ERR)
+      return 0;
 #else
     fprintf(stderr,"Not supported\n");
 #endif
@@ -1910,10 +1946,33 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
   if(set_pointer(sideinfo.main_data_begin) == MP3_ERR)
     return 0;
 
+#ifdef MP3_STATS
+  STAT_ADD(reservoir,sideinfo.main_data_begin);
+  STAT_MAX(reservoir_max,sideinfo.main_data_begin);
+  for(gr=0;gr<granules;gr++) {
+    for(ch=0;ch<stereo;ch++) {
+      struct gr_info_s *gr_info = &(sideinfo.ch[ch].gr[gr]);
+      STAT_ADD(granules,1);
+      STAT_ADD(blocktypes[gr_info->block_type],1);
+      STAT_ADD(mixedblocks,gr_info->mixed_block_flag);
+    }
+  }
+#endif
+
   for (gr=0;gr<granules;gr++) 
   {
-    static real hybridIn[2][SBLIMIT][SSLIMIT];
-    static real hybridOut[2][SSLIMIT][SBLIMIT];
+    struct mp3granule *slot = &queue->slot[(head+gr) & (MP3_QUEUE_LEN-1)];
+    real (*hybridIn)[SBLIMIT][SSLIMIT] = slot->xr;
+    long len = sideinfo.ch[0].gr[gr].part2_3_length;
+
+    /*
+     * the only bounds check: the granule has to end within the frame,
+     * overruns of a broken granule then stay within MP3_GUARD
+     */
+    if(stereo == 2)
+      len += sideinfo.ch[1].gr[gr].part2_3_length;
+    if(len > bitsleft())
+      break;
 
     {
       struct gr_info_s *gr_info = &(sideinfo.ch[0].gr[gr]);
@@ -1928,9 +1987,18 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
 #endif
       }
       if(III_dequantize_sample(hybridIn[0], scalefacs,gr_info,sfreq,part2bits))
-        return clip;
+        break;
+      STAT_STAGE(MP3_STAGE_HUFFMAN);
+    }
+    if(stereo == 2 && mid_only) {
+      struct gr_info_s *gr_info = &(sideinfo.ch[0].gr[gr]);
+      skipbits(sideinfo.ch[1].gr[gr].part2_3_length);
+      STAT_STAGE(MP3_STAGE_HUFFMAN);
+      /* the antialias butterflies leak into the band above the last one */
+      if(gr_info->maxb < SBLIMIT)
+        gr_info->maxb++;
     }
-    if(stereo == 2) {
+    else if(stereo == 2) {
       struct gr_info_s *gr_info = &(sideinfo.ch[1].gr[gr]);
       long part2bits;
       if(fr->lsf) 
@@ -1944,7 +2012,8 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
       }
 
       if(III_dequantize_sample(hybridIn[1],scalefacs,gr_info,sfreq,part2bits))
-          return clip;
+          break;
+      STAT_STAGE(MP3_STAGE_HUFFMAN);
 
       if(ms_stereo) {
         int i;
@@ -1985,26 +2054,81 @@ int do_layer3(struct frame *fr,unsigned char *pcm_sample,int *pcm_point)
           }
           break;
       }
+      STAT_STAGE(MP3_STAGE_STEREO);
     }
 
+    for(ch=0;ch<stereo1;ch++)
+      slot->gr[ch] = sideinfo.ch[ch].gr[gr];
+    slot->channels = stereo1;
+  }
+
+  /* publish the frame: its granules are only synthesised together */
+  for(ch=0;ch<gr;ch++)
+    queue->slot[(head+ch) & (MP3_QUEUE_LEN-1)].granules = gr;
+  MP3_BARRIER();
+  queue->head = head + gr;
+
+  return gr;
+}
+
+/*
+ * frequency to time stage: antialias, IMDCT and polyphase synthesis of
+ * the oldest frame in the granule queue, which must not be empty.
+ * Returns the number of clipped samples.
+ */
+int synth_layer3(unsigned char *pcm_sample,int *pcm_point)
+{
+  struct mp3queue *queue = &gmp->queue;
+  unsigned int tail = queue->tail;
+  int granules = queue->slot[tail & (MP3_QUEUE_LEN-1)].granules;
+  int stereo1 = queue->slot[tail & (MP3_QUEUE_LEN-1)].channels;
+  int (*synth)(real *,int,unsigned char *,int *) = gmp->synth;
+  int (*synth_planar)(real *,int,unsigned char *,int *) = gmp->synth_planar;
+  int gr, ch, ss, clip=0;
+  int planar,plane;
+
+  /* planar: left channel from *pcm_point on, right channel one plane further */
+  planar = (gmp->outfmt & MP3_FMT_PLANAR) && stereo1 == 2;
+  plane = granules * SSLIMIT * SBLIMIT * gmp->samplesize;
+
+  STAT_MARK(MP3_STAGE_HYBRID);
+
+  for (gr=0;gr<granules;gr++)
+  {
+    struct mp3granule *slot = &queue->slot[(tail+gr) & (MP3_QUEUE_LEN-1)];
+    static real hybridOut[2][SSLIMIT][SBLIMIT];
+
     for(ch=0;ch<stereo1;ch++) {
-      struct gr_info_s *gr_info = &(sideinfo.ch[ch].gr[gr]);
-      III_antialias(hybridIn[ch],gr_info);
-      III_hybrid(hybridIn[ch], hybridOut[ch], ch,gr_info);
+      struct gr_info_s *gr_info = &slot->gr[ch];
+      III_antialias(slot->xr[ch],gr_info);
+      III_hybrid(slot->xr[ch], hybridOut[ch], ch,gr_info);
     }
+    STAT_STAGE(MP3_STAGE_HYBRID);
 
     for(ss=0;ss<SSLIMIT;ss++) {
-      if(single >= 0) {
-        clip += synth_1to1_mono(hybridOut[0][ss],pcm_sample,pcm_point);
+      if(stereo1 == 1) {
+        clip += synth_planar(hybridOut[0][ss],0,pcm_sample,pcm_point);
+      }
+      else if(planar) {
+        int p1 = *pcm_point + plane;
+        clip += synth_planar(hybridOut[0][ss],0,pcm_sample,pcm_point);
+        clip += synth_planar(hybridOut[1][ss],1,pcm_sample,&p1);
       }
       else {
         int p1 = *pcm_point;
-        clip += synth_1to1(hybridOut[0][ss],0,pcm_sample,&p1);
-        clip += synth_1to1(hybridOut[1][ss],1,pcm_sample,pcm_point);
+        clip += synth(hybridOut[0][ss],0,pcm_sample,&p1);
+        clip += synth(hybridOut[1][ss],1,pcm_sample,pcm_point);
       }
     }
+    STAT_STAGE(MP3_STAGE_SYNTH);
   }
-  
+
+  if(planar)
+    *pcm_point += plane;
+
+  MP3_BARRIER();
+  queue->tail = tail + granules;
+
   return clip;
 }
 
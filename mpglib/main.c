@@ -5,15 +5,62 @@
 char buf[16384];
 struct mpstr mp;
 
+#ifdef MP3_THREADS
+#include <pthread.h>
+#include <sched.h>
+
+static volatile int parse_done;
+
+/* bitstream stage on its own thread, main() does the synthesis */
+static void *parse_thread(void *arg)
+{
+	int len,ret;
+
+	while(1) {
+		len = read(0,buf,16384);
+		if(len <= 0)
+			break;
+		ret = decodeMP3_parse(&mp,buf,len);
+		while(ret == MP3_OK || ret == MP3_QUEUE_FULL) {
+			if(ret == MP3_QUEUE_FULL)
+				sched_yield();
+			ret = decodeMP3_parse(&mp,NULL,0);
+		}
+	}
+	MP3_BARRIER();
+	parse_done = 1;
+	return NULL;
+}
+#endif
+
 void main(void)
 {
 	int size;
 	char out[8192];
-	int len,ret;
+	int ret;
 	
 
 	InitMP3(&mp);
 
+#ifdef MP3_THREADS
+	{
+		pthread_t parser;
+		pthread_create(&parser,NULL,parse_thread,NULL);
+		while(1) {
+			int done = parse_done;
+			ret = decodeMP3_synth(&mp,out,8192,&size);
+			if(ret == MP3_OK)
+				write(1,out,size);
+			else if(done)
+				break;
+			else
+				sched_yield();
+		}
+		pthread_join(parser,NULL);
+	}
+#else
+	int len;
+
 	while(1) {
 		len = read(0,buf,16384);
 		if(len <= 0)
@@ -24,6 +71,26 @@ void main(void)
 			ret = decodeMP3(&mp,NULL,0,out,8192,&size);
 		}
 	}
+#endif
+
+#ifdef MP3_STATS
+	{
+		struct mp3stats st;
+		GetMP3Stats(&mp,&st);
+		fprintf(stderr,"frames %lu, granules %lu, huffman bits %lu, stuffing bits %lu\n",
+			st.frames,st.granules,st.huffbits,st.stuffbits);
+		fprintf(stderr,"underruns %lu, overruns %lu, clipped %lu\n",
+			st.underruns,st.overruns,st.clipped);
+		fprintf(stderr,"block types %lu/%lu/%lu/%lu, mixed %lu\n",
+			st.blocktypes[0],st.blocktypes[1],st.blocktypes[2],st.blocktypes[3],
+			st.mixedblocks);
+		fprintf(stderr,"reservoir avg %lu max %lu\n",
+			st.frames ? st.reservoir/st.frames : 0,st.reservoir_max);
+		fprintf(stderr,"ticks huffman %lu, stereo %lu, hybrid %lu, synth %lu\n",
+			st.cycles[MP3_STAGE_HUFFMAN],st.cycles[MP3_STAGE_STEREO],
+			st.cycles[MP3_STAGE_HYBRID],st.cycles[MP3_STAGE_SYNTH]);
+	}
+#endif
 
 }
 
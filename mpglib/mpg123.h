@@ -37,6 +37,55 @@
 #define INLINE
 #endif
 
+/*
+ * Decoder statistics, see struct mp3stats. Compiled in with -DMP3_STATS,
+ * MP3_STATS_CLOCK() can be defined to a cycle counter (on the NDS e.g.
+ * cpuGetTiming()), clock() is used otherwise.
+ */
+#ifdef MP3_STATS
+# ifndef MP3_STATS_CLOCK
+#  include <time.h>
+#  define MP3_STATS_CLOCK() ((unsigned long) clock())
+# endif
+# define STAT_ADD(field,n)  (gmp->stats.field += (n))
+# define STAT_MAX(field,n)  do { unsigned long v_ = (n); \
+                               if(v_ > gmp->stats.field) gmp->stats.field = v_; } while(0)
+/* the parse and synth stages keep their own mark, they may run concurrently */
+# define STAT_SIDE(stage)   ((stage) >= MP3_STAGE_HYBRID)
+# define STAT_MARK(stage)   (gmp->stats.mark[STAT_SIDE(stage)] = MP3_STATS_CLOCK())
+# define STAT_STAGE(stage)  do { unsigned long now = MP3_STATS_CLOCK(); \
+                               gmp->stats.cycles[stage] += now - gmp->stats.mark[STAT_SIDE(stage)]; \
+                               gmp->stats.mark[STAT_SIDE(stage)] = now; } while(0)
+#else
+# define STAT_ADD(field,n)  ((void) (n))
+# define STAT_MAX(field,n)  ((void) (n))
+# define STAT_MARK(stage)
+# define STAT_STAGE(stage)
+#endif
+
+/*
+ * Orders the granule queue stores between the parse and synth stages.
+ * A full barrier on the host; the ARM946 has no other core sharing its
+ * cache, handing granules to the ARM7 additionally needs the slots
+ * flushed (DC_FlushRange) or placed in uncached main RAM.
+ */
+#ifndef MP3_BARRIER
+# ifdef ARM9
+#  define MP3_BARRIER() __asm__ __volatile__("" ::: "memory")
+# else
+#  define MP3_BARRIER() __sync_synchronize()
+# endif
+#endif
+
+/* storage of gmp, thread local where the stages may run on host threads */
+#ifndef MP3_TLS
+# ifdef ARM9
+#  define MP3_TLS
+# else
+#  define MP3_TLS __thread
+# endif
+#endif
+
 /* AUDIOBUFSIZE = n*64 with n=1,2,3 ...  */
 #define		AUDIOBUFSIZE		16384
 
@@ -53,6 +102,16 @@
 
 #define MAXFRAMESIZE 1792
 
+/*
+ * Slack behind the main data of a frame. do_layer3() checks once per
+ * granule that part2_3_length fits into the frame, the bit reader itself
+ * never checks: the big_values loop only notices that it ran past
+ * part2_3_length when it is done, which is at most 288 pairs of a 17 bit
+ * code, 2*13 linbits and two signs, plus the scalefactors and the 3
+ * bytes getbits() looks ahead.
+ */
+#define MP3_GUARD ((288*45)/8 + 32 + 4)
+
 
 /* Pre Shift fo 16 to 8 bit converter table */
 #define AUSHIFT (3)
@@ -88,13 +147,18 @@ struct parameter {
 extern unsigned int   get1bit(void);
 extern unsigned int   getbits(int);
 extern unsigned int   getbits_fast(int);
+extern void           skipbits(int);
 extern int set_pointer(long);
 
+extern int bitsleft(void);
+
 extern unsigned char *wordpointer;
+extern unsigned char *wordend;
 extern int bitindex;
 
 extern void make_decode_tables(long scaleval);
-extern int do_layer3(struct frame *fr,unsigned char *,int *);
+extern int do_layer3(struct frame *fr);
+extern int synth_layer3(unsigned char *,int *);
 extern int decode_header(struct frame *fr,unsigned long newhead);
 
 
@@ -130,7 +194,11 @@ struct III_sideinfo
 };
 
 extern int synth_1to1 (real *,int,unsigned char *,int *);
+extern int synth_1to1_planar (real *,int,unsigned char *,int *);
 extern int synth_1to1_8bit (real *,int,unsigned char *,int *);
+extern int synth_1to1_8bit_planar (real *,int,unsigned char *,int *);
+extern int synth_1to1_float (real *,int,unsigned char *,int *);
+extern int synth_1to1_float_planar (real *,int,unsigned char *,int *);
 extern int synth_1to1_mono (real *,unsigned char *,int *);
 extern int synth_1to1_mono2stereo (real *,unsigned char *,int *);
 extern int synth_1to1_8bit_mono (real *,unsigned char *,int *);
@@ -164,12 +232,12 @@ extern int get_songlen(struct frame *fr,int no);
 extern void init_layer3(int);
 extern void init_layer2(void);
 extern void make_decode_tables(long scale);
-extern void make_conv16to8_table(int);
+extern void make_conv16to8_table(void);
 extern void dct64(real *,real *,real *);
 
 extern void synth_ntom_set_step(long,long);
 
-extern unsigned char *conv16to8;
+extern unsigned char *conv16to8[2];
 extern long freqs[9];
 extern real muls[27][64];
 extern real decwin[512+32];
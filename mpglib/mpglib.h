@@ -14,19 +14,77 @@ struct framebuf {
 	struct frame *prev;
 };
 
+#ifdef MP3_STATS
+/* stages of do_layer3() and synth_layer3() timed into mp3stats.cycles[] */
+#define MP3_STAGE_HUFFMAN 0 /* side info, scalefactors, Huffman + dequantise */
+#define MP3_STAGE_STEREO  1 /* M/S, intensity stereo, downmix */
+#define MP3_STAGE_HYBRID  2 /* antialias + IMDCT */
+#define MP3_STAGE_SYNTH   3 /* polyphase synthesis */
+#define MP3_STAGES        4
+
+struct mp3stats {
+	unsigned long frames;
+	unsigned long granules;       /* counted per channel */
+	unsigned long huffbits;       /* main data bits read by the Huffman decoder */
+	unsigned long stuffbits;      /* bits left over and skipped */
+	unsigned long underruns;      /* granules that left stuffing bits */
+	unsigned long overruns;       /* granules that read past part2_3_length */
+	unsigned long clipped;        /* samples clipped by the synth */
+	unsigned long blocktypes[4];  /* long, start, short, stop */
+	unsigned long mixedblocks;
+	unsigned long reservoir;      /* sum of main_data_begin, in bytes */
+	unsigned long reservoir_max;
+	unsigned long cycles[MP3_STAGES]; /* in MP3_STATS_CLOCK() ticks */
+	unsigned long mark[2];
+};
+#endif
+
+/*
+ * Dequantised granules on their way from the bitstream stage
+ * (decodeMP3_parse) to the frequency to time stage (decodeMP3_synth).
+ * Lock-free single producer / single consumer: only the parser moves
+ * head, only the synth moves tail, both count up and wrap.
+ */
+#ifndef MP3_QUEUE_LEN
+#define MP3_QUEUE_LEN 4 /* power of two, >= 2 granules for one MPEG1 frame */
+#endif
+
+struct mp3granule {
+	real xr[2][SBLIMIT][SSLIMIT];
+	struct gr_info_s gr[2];
+	int channels;
+	int granules; /* granules of this frame, same in all of its slots */
+};
+
+struct mp3queue {
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	struct mp3granule slot[MP3_QUEUE_LEN];
+};
+
 struct mpstr {
 	struct buf *head,*tail;
 	int bsize;
 	int framesize;
         int fsizeold;
 	struct frame fr;
-        unsigned char bsspace[2][MAXFRAMESIZE+512]; /* MAXFRAMESIZE */
+        unsigned char bsspace[2][MAXFRAMESIZE+512+MP3_GUARD]; /* MAXFRAMESIZE */
 	real hybrid_block[2][2][SBLIMIT*SSLIMIT];
 	int hybrid_blc[2];
 	unsigned long header;
+	int resyncing;		/* header holds the last 4 bytes, shift on */
 	int bsnum;
 	real synth_buffs[2][2][0x110];
         int  synth_bo;
+	int outfmt;
+	int samplesize;
+	unsigned char *conv16to8;	/* S8 or U8 table, for the 8 bit synth */
+	int (*synth)(real *,int,unsigned char *,int *);
+	int (*synth_planar)(real *,int,unsigned char *,int *);
+	struct mp3queue queue;
+#ifdef MP3_STATS
+	struct mp3stats stats;
+#endif
 };
 
 #define BOOL int
@@ -34,10 +92,27 @@ struct mpstr {
 #define MP3_ERR -1
 #define MP3_OK  0
 #define MP3_NEED_MORE 1
+#define MP3_QUEUE_FULL 2
+
+/* PCM output formats for InitMP3Format() */
+#define MP3_FMT_S16    0   /* signed 16 bit, native endian (default) */
+#define MP3_FMT_S8     1   /* signed 8 bit */
+#define MP3_FMT_U8     2   /* unsigned 8 bit */
+#define MP3_FMT_FLOAT  3   /* float, -1.0 .. 1.0 */
+#define MP3_FMT_MASK   0x0f
+#define MP3_FMT_PLANAR 0x10 /* or'ed in: whole frame of left, then right */
+#define MP3_DOWNMIX    0x20 /* or'ed in: mix stereo streams down to mono */
 
 
 BOOL InitMP3(struct mpstr *mp);
+BOOL InitMP3Format(struct mpstr *mp,int format);
 int decodeMP3(struct mpstr *mp,char *inmemory,int inmemsize,
      char *outmemory,int outmemsize,int *done);
+/* the two halves of decodeMP3(), may be called from different threads */
+int decodeMP3_parse(struct mpstr *mp,char *inmemory,int inmemsize);
+int decodeMP3_synth(struct mpstr *mp,char *outmemory,int outmemsize,int *done);
 void ExitMP3(struct mpstr *mp);
+#ifdef MP3_STATS
+void GetMP3Stats(struct mpstr *mp,struct mp3stats *stats);
+#endif
 
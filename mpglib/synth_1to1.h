@@ -0,0 +1,130 @@
+/*
+ * 1to1 polyphase synthesis, one output format per inclusion.
+ *
+ * decode_i386.c includes this once for every PCM format it supports,
+ * so each format gets its own kernel that stores the samples directly
+ * instead of converting a 16 bit buffer afterwards.
+ *
+ *  SYNTH_NAME    name of the generated function
+ *  SYNTH_STEP    distance between two samples of one channel:
+ *                2 = interleaved stereo, 1 = mono / one plane
+ *  SAMPLE_T      output sample type
+ *  WRITE_SAMPLE  store (and clip) one sum, counting clipped samples
+ *  SYNTH_LOCALS  optional, declarations WRITE_SAMPLE needs (like the
+ *                decoder's 8 bit table), made once per call
+ *
+ * SYNTH_NAME and SYNTH_STEP are undefined again at the end.
+ */
+
+int SYNTH_NAME(real *bandPtr,int channel,unsigned char *out,int *pnt)
+{
+  static const int step = SYNTH_STEP;
+  int bo;
+  SAMPLE_T *samples = (SAMPLE_T *) (out + *pnt);
+
+  real *b0,(*buf)[0x110];
+  int clip = 0;
+  int bo1;
+#ifdef SYNTH_LOCALS
+  SYNTH_LOCALS
+#endif
+
+  bo = gmp->synth_bo;
+
+  if(!channel) {
+    bo--;
+    bo &= 0xf;
+    buf = gmp->synth_buffs[0];
+  }
+  else {
+#if SYNTH_STEP == 2
+    samples++;
+#endif
+    buf = gmp->synth_buffs[1];
+  }
+
+  if(bo & 0x1) {
+    b0 = buf[0];
+    bo1 = bo;
+    dct64(buf[1]+((bo+1)&0xf),buf[0]+bo,bandPtr);
+  }
+  else {
+    b0 = buf[1];
+    bo1 = bo+1;
+    dct64(buf[0]+bo,buf[1]+bo+1,bandPtr);
+  }
+
+  gmp->synth_bo = bo;
+
+  {
+    register int j;
+    real *window = decwin + 16 - bo1;
+
+    for (j=16;j;j--,b0+=0x10,window+=0x20,samples+=step)
+    {
+      real sum;
+      sum  = window[0x0] * b0[0x0];
+      sum -= window[0x1] * b0[0x1];
+      sum += window[0x2] * b0[0x2];
+      sum -= window[0x3] * b0[0x3];
+      sum += window[0x4] * b0[0x4];
+      sum -= window[0x5] * b0[0x5];
+      sum += window[0x6] * b0[0x6];
+      sum -= window[0x7] * b0[0x7];
+      sum += window[0x8] * b0[0x8];
+      sum -= window[0x9] * b0[0x9];
+      sum += window[0xA] * b0[0xA];
+      sum -= window[0xB] * b0[0xB];
+      sum += window[0xC] * b0[0xC];
+      sum -= window[0xD] * b0[0xD];
+      sum += window[0xE] * b0[0xE];
+      sum -= window[0xF] * b0[0xF];
+
+      WRITE_SAMPLE(samples,sum,clip);
+    }
+
+    {
+      real sum;
+      sum  = window[0x0] * b0[0x0];
+      sum += window[0x2] * b0[0x2];
+      sum += window[0x4] * b0[0x4];
+      sum += window[0x6] * b0[0x6];
+      sum += window[0x8] * b0[0x8];
+      sum += window[0xA] * b0[0xA];
+      sum += window[0xC] * b0[0xC];
+      sum += window[0xE] * b0[0xE];
+      WRITE_SAMPLE(samples,sum,clip);
+      b0-=0x10,window-=0x20,samples+=step;
+    }
+    window += bo1<<1;
+
+    for (j=15;j;j--,b0-=0x10,window-=0x20,samples+=step)
+    {
+      real sum;
+      sum = -window[-0x1] * b0[0x0];
+      sum -= window[-0x2] * b0[0x1];
+      sum -= window[-0x3] * b0[0x2];
+      sum -= window[-0x4] * b0[0x3];
+      sum -= window[-0x5] * b0[0x4];
+      sum -= window[-0x6] * b0[0x5];
+      sum -= window[-0x7] * b0[0x6];
+      sum -= window[-0x8] * b0[0x7];
+      sum -= window[-0x9] * b0[0x8];
+      sum -= window[-0xA] * b0[0x9];
+      sum -= window[-0xB] * b0[0xA];
+      sum -= window[-0xC] * b0[0xB];
+      sum -= window[-0xD] * b0[0xC];
+      sum -= window[-0xE] * b0[0xD];
+      sum -= window[-0xF] * b0[0xE];
+      sum -= window[-0x0] * b0[0xF];
+
+      WRITE_SAMPLE(samples,sum,clip);
+    }
+  }
+  *pnt += 32 * SYNTH_STEP * sizeof(SAMPLE_T);
+
+  return clip;
+}
+
+#undef SYNTH_NAME
+#undef SYNTH_STEP
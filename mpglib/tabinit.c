@@ -7,10 +7,8 @@ real decwin[512+32];
 static real cos64[16],cos32[8],cos16[4],cos8[2],cos4[1];
 real *pnts[] = { cos64,cos32,cos16,cos8,cos4 };
 
-#if 0
-static unsigned char *conv16to8_buf = NULL;
-unsigned char *conv16to8;
-#endif
+static unsigned char conv16to8_buf[2][8192];
+unsigned char *conv16to8[2] = { conv16to8_buf[0] + 4096, conv16to8_buf[1] + 4096 };
 
 static long intwinbase[] = {
      0,    -1,    -1,    -1,    -1,    -1,    -1,    -2,    -2,    -2,
@@ -77,4 +75,17 @@ void make_decode_tables(long scaleval)
   }
 }
 
+/*
+ * 16 bit -> 8 bit tables for the 8 bit synth, indexed by sample>>AUSHIFT:
+ * [0] signed 8 bit (NDS sound channels), [1] unsigned 8 bit (WAV).
+ * Both are built, so S8 and U8 decoders can run side by side.
+ */
+void make_conv16to8_table(void)
+{
+  int i;
 
+  for(i=-4096;i<4096;i++) {
+    conv16to8[0][i] = i>>5;
+    conv16to8[1][i] = (i>>5) + 128;
+  }
+}
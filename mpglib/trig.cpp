@@ -11,11 +11,49 @@
 	If your division really sucks, use atan2Cordic.
 	
 	This module still needs a header for some system-specific basics 
-	before you can use it. Specifically, ALIGN and QDIV will needs some 
-	extra effort.
+	before you can use it. Specifically, ALIGN and the divider (qdivBegin, 
+	qdivEnd; QDIV is both in one go) will needs some extra effort.
+
+	trigbench.cpp measures speed and accuracy of all of them. Note that
+	the generic QDIV overflows on num<<bits: keep |x|, |y| below 2^16
+	unless there's a 64-bit divide behind it.
+
+	isqrt, irsqrt, ihypot, itopolar, ifrompolar and inormalize round
+	out the set; see ROOTS AND VECTORS. They don't divide: square roots
+	are a 6-bit LUT seed plus two Newton steps on 1/sqrt, lengths and
+	angles of vectors come from CORDIC vectoring.
+
+	iatan2 points to the atan2 to use; trig_init(maxerr) times the real
+	variants and points it to the fastest one within maxerr brads, which
+	is what hardware divider, multiplier and compiler make of them. Set
+	TRIG_ATAN2=<name> in the environment (host only) or call 
+	trig_select(name) to override. Without a timer (GBA) the most 
+	accurate one wins.
+
+	The _n functions do whole arrays: isin_n, icos_n and isincos_n give
+	exactly what isin/icos give, atan2_n what atan2Tonc gives (for |x|,
+	|y| < 2^16). Quadrants and octants are folded without branches, so
+	the plain C loop suits the ARM9; SSE2 and NEON do 4 at a time
+	(TRIG_NO_SIMD turns that off).
 */
 
+#if defined(TRIG_NO_SIMD)
+#elif defined(__SSE2__)
+#define TRIG_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TRIG_NEON
+#include <arm_neon.h>
+#endif
+
+#include <string.h>
+#if !defined(__SYS_NDS__) && !defined(__SYS_GBA__)
+#include <stdlib.h>
+#include <time.h>
+#endif
+
 #include "trig.h"
+#include "triglut.h"
 
 // --------------------------------------------------------------------
 // MACROS / INLINES
@@ -30,37 +68,112 @@
 } while(0);
 
 
-#if defined(__SYS_GBA__)		
+// The divider: qdivBegin() starts (num<<bits)/den, qdivEnd() waits 
+// for it and returns the quotient. On the NDS the divider runs next to
+// the CPU, so put other work in between. There's only one of it: never
+// begin a second divide before the first is collected (and mind 
+// interrupt handlers that divide).
+
+#if defined(TRIG_QDIV)
+// qdivBegin and qdivEnd supplied by the includer (see trigbench.cpp)
+
+#elif defined(__SYS_GBA__)		
 // GBA specific
 
-static inline int QDIV(int num, int den, int bits)
+static int qdivNum, qdivDen;
+
+static inline void qdivBegin(int num, int den, int bits)
+{
+	qdivNum= num<<bits;
+	qdivDen= den;
+}
+
+static inline int qdivEnd()
 {
 	extern int Div(int, int);
-	return Div(num<<bits), den);
+	return Div(qdivNum, qdivDen);
 }
 
-#else if defined(__SYS_NDS__)
+#elif defined(__SYS_NDS__)
 // NDS specific
 
 // Special-case division because I need a little more control 
-// than divf32 offers
-static inline int QDIV(int num, int den, const int bits)
+// than divf32 offers. Writing the registers restarts the divider,
+// so there's no need to wait for it first.
+static inline void qdivBegin(int num, int den, const int bits)
 {
-	while(REG_DIVCNT & DIV_BUSY);
 	REG_DIVCNT = DIV_64_32;
 
 	REG_DIV_NUMER = ((int64)num)<<bits;
 	REG_DIV_DENOM_L = den;
+}
 
+static inline int qdivEnd()
+{
 	while(REG_DIVCNT & DIV_BUSY);
 
 	return (REG_DIV_RESULT_L);
 }
 #else
 
+static int qdivQuot;
+
+static inline void qdivBegin(int num, int den, int bits)
+{
+	qdivQuot= (num<<bits)/den;
+}
+
+static inline int qdivEnd()
+{
+	return qdivQuot;
+}
+
+#endif
+
 static inline int QDIV(int num, int den, int bits)
 {
-	return (num<<bits)/den;
+	qdivBegin(num, den, bits);
+	return qdivEnd();
+}
+
+
+// Timer for trig_init(): trigTicks() between TRIG_TIMING_BEGIN/END.
+
+#if defined(TRIG_TICKS)
+// trigTicks, TRIG_TIMING_BEGIN and _END supplied by the includer
+
+#elif defined(__SYS_NDS__)
+// Timers 2 and 3, cascaded; bus clock ticks.
+
+#define TRIG_TIMING_BEGIN()		cpuStartTiming(2)
+#define TRIG_TIMING_END()		cpuEndTiming()
+
+static inline uint trigTicks()
+{
+	return cpuGetTiming();
+}
+
+#elif defined(__SYS_GBA__)
+// No timer to spare: all candidates tie.
+
+#define TRIG_TIMING_BEGIN()
+#define TRIG_TIMING_END()
+
+static inline uint trigTicks()
+{
+	return 0;
+}
+
+#else
+
+#define TRIG_TIMING_BEGIN()
+#define TRIG_TIMING_END()
+
+static inline uint trigTicks()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000u + ts.tv_nsec;
 }
 
 #endif
@@ -83,105 +196,72 @@ static const uint TANLUT_STRIDE= BRAD_PI/TANLUT_PI, TANLUT_STRIDE_SHIFT= 6;
 static const uint ATAN_ONE = 0x1000, ATAN_FP= 12, ATAN_PI = BRAD_PI;
 static const uint ATANLUT_STRIDE = ATAN_ONE / 0x80, ATANLUT_STRIDE_SHIFT= 5;
 
+// 1/K for CORDIC steps 1..15 (K= 1.16444), Q32.
+static const uint CORDIC_INVK= 0xDBD95B17;
+
 
 // --------------------------------------------------------------------
 // LUTS
 // --------------------------------------------------------------------
 
+// Generated by triglut.h, see there for other sizes and precisions.
+
 //{{SINLUT
 #define SINLUT_SIZE		130
 #define SINLUT_FP		15
-extern const unsigned short sinLUT[130];
 
 // Sine LUT. Interval: [0, PI/2]; PI= 0x100, Q15 values.
-const unsigned short sinLUT[130] ALIGN(4)=
-{
-	0x0000,0x0192,0x0324,0x04B6,0x0648,0x07D9,0x096B,0x0AFB,
-	0x0C8C,0x0E1C,0x0FAB,0x113A,0x12C8,0x1455,0x15E2,0x176E,
-	0x18F9,0x1A83,0x1C0C,0x1D93,0x1F1A,0x209F,0x2224,0x23A7,
-	0x2528,0x26A8,0x2827,0x29A4,0x2B1F,0x2C99,0x2E11,0x2F87,
-	0x30FC,0x326E,0x33DF,0x354E,0x36BA,0x3825,0x398D,0x3AF3,
-	0x3C57,0x3DB8,0x3F17,0x4074,0x41CE,0x4326,0x447B,0x45CD,
-	0x471D,0x486A,0x49B4,0x4AFB,0x4C40,0x4D81,0x4EC0,0x4FFB,
-	0x5134,0x5269,0x539B,0x54CA,0x55F6,0x571E,0x5843,0x5964,
-// 64
-	0x5A82,0x5B9D,0x5CB4,0x5DC8,0x5ED7,0x5FE4,0x60EC,0x61F1,
-	0x62F2,0x63EF,0x64E9,0x65DE,0x66D0,0x67BD,0x68A7,0x698C,
-	0x6A6E,0x6B4B,0x6C24,0x6CF9,0x6DCA,0x6E97,0x6F5F,0x7023,
-	0x70E3,0x719E,0x7255,0x7308,0x73B6,0x7460,0x7505,0x75A6,
-	0x7642,0x76D9,0x776C,0x77FB,0x7885,0x790A,0x798A,0x7A06,
-	0x7A7D,0x7AEF,0x7B5D,0x7BC6,0x7C2A,0x7C89,0x7CE4,0x7D3A,
-	0x7D8A,0x7DD6,0x7E1E,0x7E60,0x7E9D,0x7ED6,0x7F0A,0x7F38,
-	0x7F62,0x7F87,0x7FA7,0x7FC2,0x7FD9,0x7FEA,0x7FF6,0x7FFE,
-// 128
-	0x8000,0x7FFE
-};
+static const SinLut<SINLUT_PI_SHIFT-1, SINLUT_FP> &sinLUT= 
+	sinLut<SINLUT_PI_SHIFT-1, SINLUT_FP>;
+static_assert(sinLUT.SIZE == SINLUT_SIZE && sinLut<7,15>[64] == 0x5A82 
+	&& sinLut<7,15>[129] == 0x7FFE, "sinLUT differs from the classic table");
 //}}SINLUT
 
 
 //{{TANLUT
 #define TANLUT_SIZE		129
 #define TANLUT_FP		16
-extern const unsigned int tanLUT[129];
 
 // Tangens LUT, domain: [0, PI/2]; PI= 0x100, Q16 values.
 // tan(PI/2) set to 400.
-const unsigned int tanLUT[129]=
-{
-	0x00000000,0x00000324,0x00000649,0x0000096E,0x00000C94,0x00000FBA,0x000012E2,0x0000160C,
-	0x00001937,0x00001C64,0x00001F93,0x000022C5,0x000025F9,0x00002931,0x00002C6C,0x00002FAA,
-	0x000032EC,0x00003632,0x0000397D,0x00003CCC,0x00004020,0x00004379,0x000046D8,0x00004A3D,
-	0x00004DA8,0x0000511A,0x00005492,0x00005812,0x00005B99,0x00005F28,0x000062C0,0x00006660,
-	0x00006A0A,0x00006DBD,0x0000717A,0x00007542,0x00007914,0x00007CF2,0x000080DC,0x000084D2,
-	0x000088D6,0x00008CE7,0x00009106,0x00009534,0x00009971,0x00009DBE,0x0000A21C,0x0000A68C,
-	0x0000AB0E,0x0000AFA3,0x0000B44C,0x0000B909,0x0000BDDD,0x0000C2C7,0x0000C7C9,0x0000CCE3,
-	0x0000D218,0x0000D768,0x0000DCD4,0x0000E25E,0x0000E806,0x0000EDD0,0x0000F3BB,0x0000F9CB,
-// 64
-	0x00010000,0x0001065D,0x00010CE3,0x00011394,0x00011A74,0x00012184,0x000128C6,0x0001303F,
-	0x000137F0,0x00013FDD,0x00014809,0x00015077,0x0001592D,0x0001622E,0x00016B7E,0x00017523,
-	0x00017F22,0x00018980,0x00019445,0x00019F76,0x0001AB1C,0x0001B73F,0x0001C3E7,0x0001D11F,
-	0x0001DEF1,0x0001ED6A,0x0001FC96,0x00020C84,0x00021D44,0x00022EE9,0x00024187,0x00025534,
-	0x00026A0A,0x00028026,0x000297A8,0x0002B0B5,0x0002CB79,0x0002E823,0x000306EC,0x00032816,
-	0x00034BEB,0x000372C6,0x00039D11,0x0003CB48,0x0003FE02,0x000435F7,0x00047405,0x0004B940,
-	0x00050700,0x00055EF9,0x0005C35D,0x00063709,0x0006BDD0,0x00075CE6,0x00081B98,0x0009046E,
-	0x000A2736,0x000B9CC6,0x000D8E82,0x001046EA,0x00145B00,0x001B2672,0x0028BC49,0x00517BB6,
-// 128
-	0x01900000
-};
+static const TanLut<TANLUT_PI_SHIFT-1, TANLUT_FP> &tanLUT= 
+	tanLut<TANLUT_PI_SHIFT-1, TANLUT_FP>;
+static_assert(tanLut<7,16>[64] == 0x10000 && tanLut<7,16>[127] == 0x00517BB6
+	&& tanLut<7,16>[128] == 0x01900000, "tanLUT differs from the classic table");
 //}}TANLUT
 
 
 //{{ATANLUT
 #define ATANLUT_SIZE	130
 #define ATANLUT_FP		15
-extern const unsigned short atanLUT[130];
 
 // Arctangens LUT. Interval: [0, 1] (one=128); PI=0x20000
-const unsigned short atanLUT[130] ALIGN(4)=
-{
-	0x0000,0x0146,0x028C,0x03D2,0x0517,0x065D,0x07A2,0x08E7,
-	0x0A2C,0x0B71,0x0CB5,0x0DF9,0x0F3C,0x107F,0x11C1,0x1303,
-	0x1444,0x1585,0x16C5,0x1804,0x1943,0x1A80,0x1BBD,0x1CFA,
-	0x1E35,0x1F6F,0x20A9,0x21E1,0x2319,0x2450,0x2585,0x26BA,
-	0x27ED,0x291F,0x2A50,0x2B80,0x2CAF,0x2DDC,0x2F08,0x3033,
-	0x315D,0x3285,0x33AC,0x34D2,0x35F6,0x3719,0x383A,0x395A,
-	0x3A78,0x3B95,0x3CB1,0x3DCB,0x3EE4,0x3FFB,0x4110,0x4224,
-	0x4336,0x4447,0x4556,0x4664,0x4770,0x487A,0x4983,0x4A8B,
-// 64
-	0x4B90,0x4C94,0x4D96,0x4E97,0x4F96,0x5093,0x518F,0x5289,
-	0x5382,0x5478,0x556E,0x5661,0x5753,0x5843,0x5932,0x5A1E,
-	0x5B0A,0x5BF3,0x5CDB,0x5DC1,0x5EA6,0x5F89,0x606A,0x614A,
-	0x6228,0x6305,0x63E0,0x64B9,0x6591,0x6667,0x673B,0x680E,
-	0x68E0,0x69B0,0x6A7E,0x6B4B,0x6C16,0x6CDF,0x6DA8,0x6E6E,
-	0x6F33,0x6FF7,0x70B9,0x717A,0x7239,0x72F6,0x73B3,0x746D,
-	0x7527,0x75DF,0x7695,0x774A,0x77FE,0x78B0,0x7961,0x7A10,
-	0x7ABF,0x7B6B,0x7C17,0x7CC1,0x7D6A,0x7E11,0x7EB7,0x7F5C,
-// 128
-	0x8000,0x80A2
-};
+static const AtanLut<7, ATANLUT_FP> &atanLUT= atanLut<7, ATANLUT_FP>;
+static_assert(atanLut<7,15>[1] == 0x0146 && atanLut<7,15>[128] == 0x8000
+	&& atanLut<7,15>[129] == 0x80A2, "atanLUT differs from the classic table");
 //}}ATANLUT
 
 
+//{{CORDICLUT
+#define CORDICLUT_SIZE	16
+
+// atan(2^-i) terms using PI=0x10000
+static const unsigned short cordicLUT[CORDICLUT_SIZE]=
+{ 
+	0x4000, 0x25C8, 0x13F6, 0x0A22, 0x0516, 0x028C, 0x0146, 0x00A3, 
+	0x0051, 0x0029, 0x0014, 0x000A, 0x0005, 0x0003, 0x0001, 0x0001
+};
+//}}CORDICLUT
+
+
+//{{RSQRTLUT
+#define RSQRTLUT_BITS	6
+
+// 1/sqrt(m) seeds, m in [1/4, 1) (top 6 bits); Q15 values.
+static const RsqrtLut<RSQRTLUT_BITS> &rsqrtLUT= rsqrtLut<RSQRTLUT_BITS>;
+//}}RSQRTLUT
+
+
 // --------------------------------------------------------------------
 // FUNCTIONS
 // --------------------------------------------------------------------
@@ -219,27 +299,7 @@ static inline uint lutBracket(const T &key, const T array[], uint size)
 */
 int isin(int x)
 {
-	int h, ya, yb, y;
-	uint ux, quad;
-
-	ux= (uint)x%BRAD_2PI;
-	h= ux % SINLUT_STRIDE;
-	quad= ux/SINLUT_STRIDE / SINLUT_HPI;
-	ux= ux/SINLUT_STRIDE % SINLUT_HPI;
-	
-	if(quad & 1)
-	{
-		ya= sinLUT[SINLUT_HPI-ux  ];
-		yb= sinLUT[SINLUT_HPI-ux-1];
-	}
-	else
-	{
-		ya= sinLUT[ux  ];
-		yb= sinLUT[ux+1];
-	}
-
-	y=(ya + ((yb-ya)*h >> SINLUT_STRIDE_SHIFT))>>3;
-	return (quad & 2) ? -y : +y;
+	return isinT<SINLUT_PI_SHIFT-1, SINLUT_FP, 12>(x);
 }
 
 
@@ -250,29 +310,7 @@ int isin(int x)
 */
 int icos(int x)
 {
-	int h, ya, yb, y;
-	uint ux, quad;
-
-	x += BRAD_HPI;
-	ux= (uint)x % BRAD_2PI;
-	h= ux % SINLUT_STRIDE;
-	quad= ux/SINLUT_STRIDE / SINLUT_HPI;
-	ux= ux/SINLUT_STRIDE % SINLUT_HPI;
-	
-
-	if(quad & 1)
-	{
-		ya= sinLUT[SINLUT_HPI-ux  ];
-		yb= sinLUT[SINLUT_HPI-ux-1];
-	}
-	else
-	{
-		ya= sinLUT[ux  ];
-		yb= sinLUT[ux+1];
-	}
-
-	y=(ya + ((yb-ya)*h >> SINLUT_STRIDE_SHIFT))>>3;
-	return (quad & 2) ? -y : +y;
+	return icosT<SINLUT_PI_SHIFT-1, SINLUT_FP, 12>(x);
 }
 
 //! Get a tangent value as a Q12 fixed-point number.
@@ -282,22 +320,7 @@ int icos(int x)
 */
 int itan(int x)
 {
-	uint ux= (uint)x % BRAD_PI;
-	uint xa= ux / TANLUT_STRIDE;
-	int ya, yb, h= ux % TANLUT_STRIDE;
-
-	if(ux <= BRAD_HPI)
-	{
-		ya= tanLUT[xa  ];
-		yb= tanLUT[xa+1];
-	}
-	else
-	{
-		ya= -tanLUT[TANLUT_PI-xa  ];
-		yb= -tanLUT[TANLUT_PI-xa-1];
-	}
-
-	return (ya + ((yb-ya)*h >> TANLUT_STRIDE_SHIFT))>>4;
+	return itanT<TANLUT_PI_SHIFT-1, TANLUT_FP, 12>(x);
 }
 
 
@@ -389,7 +412,7 @@ uint atan2InvLerp(int x, int y)
 	phi *= BRAD_PI/4;
 
 	t= QDIV(y, x, TANLUT_FP);
-	fa= lutBracket(t, tanLUT, TANLUT_SIZE);
+	fa= lutBracket(t, tanLUT.data, TANLUT_SIZE);
 	ta= tanLUT[fa  ];
 	tb= tanLUT[fa+1];
 
@@ -459,9 +482,10 @@ uint atan2Tonc(int x, int y)
 	int  phi, t, t2, dphi;
 
 	OCTANTIFY(x, y, phi);
+	qdivBegin(y, x, fixShift);
 	phi *= BRAD_PI/4;
 
-	t= QDIV(y, x, fixShift);
+	t= qdivEnd();
 	t2= -t*t>>fixShift;
 
 	dphi= 0x0470;
@@ -510,13 +534,6 @@ uint atan2Cordic(int x, int y)
 		y *= 0x1000;
 	}
 
-	// atan(2^-i) terms using PI=0x10000
-	const u16 list[]=
-	{ 
-		0x4000, 0x25C8, 0x13F6, 0x0A22, 0x0516, 0x028C, 0x0146, 0x00A3, 
-		0x0051, 0x0029, 0x0014, 0x000A, 0x0005, 0x0003, 0x0001, 0x0001
-	};
-
 	int i, tmp, dphi=0;
 	for(i=1; i<12; i++)
 	{
@@ -525,17 +542,657 @@ uint atan2Cordic(int x, int y)
 			tmp= x + (y>>i);
 			y  = y - (x>>i);
 			x  = tmp;
-			dphi += list[i];
+			dphi += cordicLUT[i];
 		}
 		else
 		{
 			tmp= x - (y>>i);
 			y  = y + (x>>i);
 			x  = tmp;
-			dphi -= list[i];
+			dphi -= cordicLUT[i];
 		}
 	}
 	return phi + (dphi>>2);
 }
 
+
+// --------------------------------------------------------------------
+// DISPATCH
+// --------------------------------------------------------------------
+
+#define TRIG_BENCH_POINTS	32
+#define TRIG_BENCH_ROUNDS	8
+
+//! Candidates for iatan2, most accurate first. The errors are from 
+//! trigbench, with the NDS divider model.
+static TrigAtan2 trigAtan2List[]=
+{
+	{ "atan2Tonc",		atan2Tonc,		  1, 0 },
+	{ "atan2Gba",		atan2Gba,		  2, 0 },
+	{ "atan2Lerp",		atan2Lerp,		  3, 0 },
+	{ "atan2InvLerp",	atan2InvLerp,	  3, 0 },
+	{ "atan2Cordic",	atan2Cordic,	  4, 0 },
+	{ "atan2Sin",		atan2Sin,		  6, 0 },
+	{ "atan2Lookup",	atan2Lookup,	 42, 0 },
+	{ "atan2Taylor",	atan2Taylor,	156, 0 },
+};
+
+atan2Fn iatan2= atan2Tonc;
+
+//! Best of three runs over a fixed spread of points.
+static uint trigTime(atan2Fn fn)
+{
+	static uint sink;
+	short pts[TRIG_BENCH_POINTS][2];
+	uint ii, rep, run, t, best= ~0u, seed= 0x2545F491;
+
+	// |x|, |y| < 2^14, from an LCG.
+	for(ii=0; ii<TRIG_BENCH_POINTS; ii++)
+	{
+		seed= seed*1664525 + 1013904223;
+		pts[ii][0]= (int)seed>>17;
+		seed= seed*1664525 + 1013904223;
+		pts[ii][1]= (int)seed>>17;
+	}
+
+	for(run=0; run<3; run++)
+	{
+		t= trigTicks();
+		for(rep=0; rep<TRIG_BENCH_ROUNDS; rep++)
+			for(ii=0; ii<TRIG_BENCH_POINTS; ii++)
+				sink += fn(pts[ii][0], pts[ii][1]);
+		t= trigTicks() - t;
+		if(t < best)
+			best= t;
+	}
+	return best;
+}
+
+//! Put the atan2 called \a name in iatan2.
+/*! \return	Its entry, or NULL (and iatan2 unchanged) if there's none. */
+const TrigAtan2 *trig_select(const char *name)
+{
+	uint ii;
+
+	for(ii=0; ii<countof(trigAtan2List); ii++)
+	{
+		if(strcmp(trigAtan2List[ii].name, name) == 0)
+		{
+			iatan2= trigAtan2List[ii].fn;
+			return &trigAtan2List[ii];
+		}
+	}
+	return NULL;
+}
+
+//! Time the atan2s and put the fastest within \a maxerr brads in iatan2.
+/*! If none is accurate enough, the most accurate one is used. 
+	\return	The chosen one.
+*/
+const TrigAtan2 *trig_init(uint maxerr)
+{
+	TrigAtan2 *best= NULL;
+	uint ii;
+
+	TRIG_TIMING_BEGIN();
+	for(ii=0; ii<countof(trigAtan2List); ii++)
+		trigAtan2List[ii].ticks= trigTime(trigAtan2List[ii].fn);
+	TRIG_TIMING_END();
+
+#if !defined(__SYS_NDS__) && !defined(__SYS_GBA__)
+	const char *name= getenv("TRIG_ATAN2");
+	const TrigAtan2 *forced= name ? trig_select(name) : NULL;
+	if(forced)
+		return forced;
+#endif
+
+	for(ii=0; ii<countof(trigAtan2List); ii++)
+	{
+		TrigAtan2 *ta= &trigAtan2List[ii];
+		if(ta->maxerr <= maxerr && (!best || ta->ticks < best->ticks))
+			best= ta;
+	}
+	if(!best)
+		best= &trigAtan2List[0];
+
+	iatan2= best->fn;
+	return best;
+}
+
+//! All candidates, with trig_init()'s timings.
+const TrigAtan2 *trig_atan2_list(uint *count)
+{
+	*count= countof(trigAtan2List);
+	return trigAtan2List;
+}
+
+
+// --------------------------------------------------------------------
+// BATCH FUNCTIONS
+// --------------------------------------------------------------------
+
+//! Branchless isin() for an angle already in [0, BRAD_2PI).
+static inline int isinFold(uint ux)
+{
+	uint quad= ux>>(BRAD_PI_SHIFT-1);
+	uint odd= quad & 1;
+	uint ia= ux>>SINLUT_STRIDE_SHIFT & (SINLUT_HPI-1);
+	int h= ux & (SINLUT_STRIDE-1);
+	int ya, yb, y, sign;
+
+	// Odd quadrants run backwards: SINLUT_HPI-ia and one step down.
+	ia= (ia ^ -odd) + (-odd & (SINLUT_HPI+1));
+	ya= sinLUT[ia];
+	yb= sinLUT[ia+1-2*odd];
+
+	y= (ya + ((yb-ya)*h >> SINLUT_STRIDE_SHIFT))>>3;
+	sign= -(int)(quad>>1);
+	return (y^sign) - sign;
+}
+
+static const int ATAN2_FIX= 15;
+
+//! atan2Tonc()'s octant fold for atan2_n: folded x and y, and the
+//! octant base (or, for y==0, the axis) to add to the polynomial.
+struct Atan2Oct
+{
+	int x, y;
+	int onAxis;
+	uint phi, axis;
+};
+
+//! Branchless OCTANTIFY. Afterwards 0 <= y <= x and x > 0.
+static inline void atan2Octant(int x, int y, Atan2Oct *o)
+{
+	int mask, tmp, phi;
+
+	o->onAxis= -(y==0);
+	o->axis= (x<0 ? BRAD_PI : 0);
+
+	mask= y>>31;
+	x= (x^mask) - mask;
+	y= (y^mask) - mask;
+	phi= mask & 4;
+
+	mask= -(x<=0);
+	tmp= x;
+	x= (y & mask) | (x & ~mask);
+	y= (-tmp & mask) | (y & ~mask);
+	phi += mask & 2;
+
+	mask= -(x<=y);
+	tmp= y-x;
+	x= ((x+y) & mask) | (x & ~mask);
+	y= (tmp & mask) | (y & ~mask);
+	phi += mask & 1;
+
+	o->x= x | (x==0);	// only for (0,0), which is on the axis anyway
+	o->y= y;
+	o->phi= phi*(BRAD_PI/4);
+}
+
+//! atan2Tonc()'s polynomial on t= y/x (Q15) of a folded pair.
+static inline uint atan2Poly(const Atan2Oct *o, int t)
+{
+	const int fixShift= ATAN2_FIX;
+	int t2, dphi;
+	uint res;
+
+	t2= -t*t>>fixShift;
+
+	dphi= 0x0470;
+	dphi= 0x1029 + (t2*dphi>>fixShift);
+	dphi= 0x1F0B + (t2*dphi>>fixShift);
+	dphi= 0x364C + (t2*dphi>>fixShift);
+	dphi= 0xA2FC + (t2*dphi>>fixShift);
+	dphi= dphi*t>>fixShift;
+
+	res= o->phi + ((dphi+4)>>3);
+	return (res & ~o->onAxis) | (o->axis & o->onAxis);
+}
+
+
+#if defined(TRIG_SSE2)
+
+//! Four isinFold()s. Lookups are scalar, SSE2 has no gather.
+static inline __m128i isinFold4(__m128i x)
+{
+	const __m128i one= _mm_set1_epi32(1);
+	int ALIGN(16) ia[4], ib[4];
+	__m128i quad, odd, nodd, idx, h, ya, yb, y, sign;
+
+	x= _mm_and_si128(x, _mm_set1_epi32(BRAD_2PI-1));
+	quad= _mm_srli_epi32(x, BRAD_PI_SHIFT-1);
+	odd= _mm_and_si128(quad, one);
+	nodd= _mm_sub_epi32(_mm_setzero_si128(), odd);
+	h= _mm_and_si128(x, _mm_set1_epi32(SINLUT_STRIDE-1));
+
+	idx= _mm_and_si128(_mm_srli_epi32(x, SINLUT_STRIDE_SHIFT), _mm_set1_epi32(SINLUT_HPI-1));
+	idx= _mm_add_epi32(_mm_xor_si128(idx, nodd), _mm_and_si128(nodd, _mm_set1_epi32(SINLUT_HPI+1)));
+	_mm_store_si128((__m128i*)ia, idx);
+	_mm_store_si128((__m128i*)ib, _mm_sub_epi32(_mm_add_epi32(idx, one), _mm_add_epi32(odd, odd)));
+
+	ya= _mm_set_epi32(sinLUT[ia[3]], sinLUT[ia[2]], sinLUT[ia[1]], sinLUT[ia[0]]);
+	yb= _mm_set_epi32(sinLUT[ib[3]], sinLUT[ib[2]], sinLUT[ib[1]], sinLUT[ib[0]]);
+
+	// |yb-ya| and h both fit in 16 bits: pmaddwd is the 32-bit multiply.
+	y= _mm_and_si128(_mm_sub_epi32(yb, ya), _mm_set1_epi32(0xFFFF));
+	y= _mm_madd_epi16(y, h);
+	y= _mm_srai_epi32(_mm_add_epi32(ya, _mm_srai_epi32(y, SINLUT_STRIDE_SHIFT)), 3);
+
+	sign= _mm_sub_epi32(_mm_setzero_si128(), _mm_srli_epi32(quad, 1));
+	return _mm_sub_epi32(_mm_xor_si128(y, sign), sign);
+}
+
+//! Low 32 bits of a 32x32 multiply, which SSE2 only has for 16 bits.
+static inline __m128i mullo4(__m128i a, __m128i b)
+{
+	__m128i lo= _mm_mul_epu32(a, b);
+	__m128i hi= _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(lo, _MM_SHUFFLE(0,0,2,0)),
+		_mm_shuffle_epi32(hi, _MM_SHUFFLE(0,0,2,0)));
+}
+
+//! (y<<15)/x for four lanes. Exact through doubles, and without the
+//! overflow of the generic QDIV.
+static inline __m128i qdiv4(__m128i y, __m128i x)
+{
+	const __m128d scale= _mm_set1_pd(1<<15);
+	__m128i lo, hi;
+
+	lo= _mm_cvttpd_epi32(_mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(y), scale),
+		_mm_cvtepi32_pd(x)));
+	y= _mm_srli_si128(y, 8);
+	x= _mm_srli_si128(x, 8);
+	hi= _mm_cvttpd_epi32(_mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(y), scale),
+		_mm_cvtepi32_pd(x)));
+
+	return _mm_unpacklo_epi64(lo, hi);
+}
+
+//! atan2Octant() and atan2Poly() on four pairs.
+static inline __m128i atan2Fold4(__m128i x, __m128i y)
+{
+	const __m128i zero= _mm_setzero_si128();
+	__m128i mask, tmp, phi, t, t2, dphi, res, axis, onAxis;
+
+	axis= _mm_and_si128(_mm_cmplt_epi32(x, zero), _mm_set1_epi32(BRAD_PI));
+	onAxis= _mm_cmpeq_epi32(y, zero);
+
+	mask= _mm_srai_epi32(y, 31);
+	x= _mm_sub_epi32(_mm_xor_si128(x, mask), mask);
+	y= _mm_sub_epi32(_mm_xor_si128(y, mask), mask);
+	phi= _mm_and_si128(mask, _mm_set1_epi32(4));
+
+	mask= _mm_cmpgt_epi32(_mm_set1_epi32(1), x);			// x<=0
+	tmp= x;
+	x= _mm_or_si128(_mm_and_si128(mask, y), _mm_andnot_si128(mask, x));
+	y= _mm_or_si128(_mm_and_si128(mask, _mm_sub_epi32(zero, tmp)), _mm_andnot_si128(mask, y));
+	phi= _mm_add_epi32(phi, _mm_and_si128(mask, _mm_set1_epi32(2)));
+
+	mask= _mm_cmpgt_epi32(_mm_add_epi32(y, _mm_set1_epi32(1)), x);	// x<=y
+	tmp= _mm_sub_epi32(y, x);
+	x= _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(x, y)), _mm_andnot_si128(mask, x));
+	y= _mm_or_si128(_mm_and_si128(mask, tmp), _mm_andnot_si128(mask, y));
+	phi= _mm_add_epi32(phi, _mm_and_si128(mask, _mm_set1_epi32(1)));
+
+	x= _mm_or_si128(x, _mm_and_si128(_mm_cmpeq_epi32(x, zero), _mm_set1_epi32(1)));
+	t= qdiv4(y, x);
+	t2= _mm_srai_epi32(mullo4(_mm_sub_epi32(zero, t), t), 15);
+
+	dphi= _mm_set1_epi32(0x0470);
+	dphi= _mm_add_epi32(_mm_set1_epi32(0x1029), _mm_srai_epi32(mullo4(t2, dphi), 15));
+	dphi= _mm_add_epi32(_mm_set1_epi32(0x1F0B), _mm_srai_epi32(mullo4(t2, dphi), 15));
+	dphi= _mm_add_epi32(_mm_set1_epi32(0x364C), _mm_srai_epi32(mullo4(t2, dphi), 15));
+	dphi= _mm_add_epi32(_mm_set1_epi32(0xA2FC), _mm_srai_epi32(mullo4(t2, dphi), 15));
+	dphi= _mm_srai_epi32(mullo4(dphi, t), 15);
+
+	res= _mm_add_epi32(_mm_slli_epi32(phi, BRAD_PI_SHIFT-2),
+		_mm_srai_epi32(_mm_add_epi32(dphi, _mm_set1_epi32(4)), 3));
+	return _mm_or_si128(_mm_andnot_si128(onAxis, res), _mm_and_si128(onAxis, axis));
+}
+
+#define TRIG_SIMD_SIN	1
+#define TRIG_SIMD_ATAN2	1
+
+typedef __m128i trig_vec;
+#define VLOAD(_p)		_mm_loadu_si128((const __m128i*)(_p))
+#define VSTORE(_p, _v)	_mm_storeu_si128((__m128i*)(_p), _v)
+#define VADD(_a, _n)	_mm_add_epi32(_a, _mm_set1_epi32(_n))
+
+#elif defined(TRIG_NEON)
+
+//! Four isinFold()s. Lookups are scalar, NEON has no gather.
+static inline int32x4_t isinFold4(int32x4_t sx)
+{
+	const uint32x4_t one= vdupq_n_u32(1);
+	uint32_t ALIGN(16) ia[4], ib[4];
+	uint32x4_t x, quad, odd, nodd, idx;
+	int32x4_t h, ya, yb, y, sign;
+
+	x= vandq_u32(vreinterpretq_u32_s32(sx), vdupq_n_u32(BRAD_2PI-1));
+	quad= vshrq_n_u32(x, BRAD_PI_SHIFT-1);
+	odd= vandq_u32(quad, one);
+	nodd= vreinterpretq_u32_s32(vnegq_s32(vreinterpretq_s32_u32(odd)));
+	h= vreinterpretq_s32_u32(vandq_u32(x, vdupq_n_u32(SINLUT_STRIDE-1)));
+
+	idx= vandq_u32(vshrq_n_u32(x, SINLUT_STRIDE_SHIFT), vdupq_n_u32(SINLUT_HPI-1));
+	idx= vaddq_u32(veorq_u32(idx, nodd), vandq_u32(nodd, vdupq_n_u32(SINLUT_HPI+1)));
+	vst1q_u32(ia, idx);
+	vst1q_u32(ib, vsubq_u32(vaddq_u32(idx, one), vaddq_u32(odd, odd)));
+
+	ya= vdupq_n_s32(0);
+	ya= vsetq_lane_s32(sinLUT[ia[0]], ya, 0);
+	ya= vsetq_lane_s32(sinLUT[ia[1]], ya, 1);
+	ya= vsetq_lane_s32(sinLUT[ia[2]], ya, 2);
+	ya= vsetq_lane_s32(sinLUT[ia[3]], ya, 3);
+	yb= vdupq_n_s32(0);
+	yb= vsetq_lane_s32(sinLUT[ib[0]], yb, 0);
+	yb= vsetq_lane_s32(sinLUT[ib[1]], yb, 1);
+	yb= vsetq_lane_s32(sinLUT[ib[2]], yb, 2);
+	yb= vsetq_lane_s32(sinLUT[ib[3]], yb, 3);
+
+	y= vmulq_s32(vsubq_s32(yb, ya), h);
+	y= vshrq_n_s32(vaddq_s32(ya, vshrq_n_s32(y, SINLUT_STRIDE_SHIFT)), 3);
+
+	sign= vnegq_s32(vreinterpretq_s32_u32(vshrq_n_u32(quad, 1)));
+	return vsubq_s32(veorq_s32(y, sign), sign);
+}
+
+// ARMv7 NEON can't divide, so atan2_n stays scalar.
+#define TRIG_SIMD_SIN	1
+#define TRIG_SIMD_ATAN2	0
+
+typedef int32x4_t trig_vec;
+#define VLOAD(_p)		vld1q_s32(_p)
+#define VSTORE(_p, _v)	vst1q_s32(_p, _v)
+#define VADD(_a, _n)	vaddq_s32(_a, vdupq_n_s32(_n))
+
+#else
+
+#define TRIG_SIMD_SIN	0
+#define TRIG_SIMD_ATAN2	0
+
+#endif
+
+// An includer's divider has to do all divides.
+#if defined(TRIG_QDIV)
+#undef TRIG_SIMD_ATAN2
+#define TRIG_SIMD_ATAN2	0
+#endif
+
+
+//! Sines of \a n angles, same as isin() on each.
+void isin_n(const int *angles, int *out, size_t n)
+{
+	size_t ii= 0;
+
+#if TRIG_SIMD_SIN
+	for( ; ii+4<=n; ii += 4)
+		VSTORE(&out[ii], isinFold4(VLOAD(&angles[ii])));
+#endif
+	for( ; ii<n; ii++)
+		out[ii]= isinFold((uint)angles[ii] & (BRAD_2PI-1));
+}
+
+//! Cosines of \a n angles, same as icos() on each.
+void icos_n(const int *angles, int *out, size_t n)
+{
+	size_t ii= 0;
+
+#if TRIG_SIMD_SIN
+	for( ; ii+4<=n; ii += 4)
+		VSTORE(&out[ii], isinFold4(VADD(VLOAD(&angles[ii]), BRAD_HPI)));
+#endif
+	for( ; ii<n; ii++)
+		out[ii]= isinFold((uint)(angles[ii]+BRAD_HPI) & (BRAD_2PI-1));
+}
+
+//! Sines and cosines of \a n angles.
+void isincos_n(const int *angles, int *sins, int *coss, size_t n)
+{
+	size_t ii= 0;
+
+#if TRIG_SIMD_SIN
+	for( ; ii+4<=n; ii += 4)
+	{
+		trig_vec x= VLOAD(&angles[ii]);
+		VSTORE(&sins[ii], isinFold4(x));
+		VSTORE(&coss[ii], isinFold4(VADD(x, BRAD_HPI)));
+	}
+#endif
+	for( ; ii<n; ii++)
+	{
+		uint ux= angles[ii];
+		sins[ii]= isinFold(ux & (BRAD_2PI-1));
+		coss[ii]= isinFold((ux+BRAD_HPI) & (BRAD_2PI-1));
+	}
+}
+
+//! atan2Tonc() of \a n coordinate pairs.
+/*! Without SIMD the divides are pipelined: pair ii+1 is divided while 
+	pair ii goes through the polynomial and pair ii+2 gets folded.
+*/
+void atan2_n(const int *x, const int *y, uint *out, size_t n)
+{
+	size_t ii= 0;
+
+#if TRIG_SIMD_ATAN2
+	for( ; ii+4<=n; ii += 4)
+		VSTORE(&out[ii], atan2Fold4(VLOAD(&x[ii]), VLOAD(&y[ii])));
+#endif
+	if(ii >= n)
+		return;
+
+	Atan2Oct cur, next;
+	int t;
+
+	atan2Octant(x[ii], y[ii], &cur);
+	qdivBegin(cur.y, cur.x, ATAN2_FIX);
+	for( ; ii+1<n; ii++)
+	{
+		atan2Octant(x[ii+1], y[ii+1], &next);
+		t= qdivEnd();
+		qdivBegin(next.y, next.x, ATAN2_FIX);
+		out[ii]= atan2Poly(&cur, t);
+		cur= next;
+	}
+	out[ii]= atan2Poly(&cur, qdivEnd());
+}
+
+
+// --------------------------------------------------------------------
+// ROOTS AND VECTORS
+// --------------------------------------------------------------------
+
+//! 1/sqrt(m) for a Q32 \a m in [1/4, 1), as Q30.
+/*! LUT seed (~1.5% off) and two Newton steps y*(3 - m*y^2)/2, which 
+	approach from below, so the result never exceeds 2<<30.
+*/
+static inline uint rsqrtNorm(uint m)
+{
+	uint y= rsqrtLUT[(m>>(32-RSQRTLUT_BITS)) - rsqrtLUT.BASE]<<15;
+	uint my2;
+
+	for(int i=0; i<2; i++)
+	{
+		my2= ((unsigned long long)y*y >> 30)*m >> 32;
+		y= (unsigned long long)y*((3u<<30) - my2) >> 31;
+	}
+	return y;
+}
+
+//! Integer square root, rounded down.
+/*! For a Q(2n) number the result is Q(n): the Q12 root of a Q12 
+	number is isqrt(x<<12), for x < 2^20.
+*/
+uint isqrt(uint x)
+{
+	if(x == 0)	
+		return 0;
+
+	uint lz= __builtin_clz(x) & ~1, m= x<<lz;
+	uint r= (unsigned long long)m*rsqrtNorm(m) >> (46 + lz/2);
+
+	// Newton leaves r at most 1 off.
+	if((unsigned long long)r*r > x)
+		r--;
+	else if((unsigned long long)(r+1)*(r+1) <= x)
+		r++;
+	return r;
+}
+
+//! Reciprocal square root as a Q30 number: 2^30/sqrt(x).
+/*! Good to 2^-21 relative or 1 unit, whichever is larger. 
+	irsqrt(0) gives 0xFFFFFFFF.
+*/
+uint irsqrt(uint x)
+{
+	if(x == 0)
+		return 0xFFFFFFFF;
+
+	uint lz= __builtin_clz(x) & ~1;
+	return rsqrtNorm(x<<lz) >> (16 - lz/2);
+}
+
+//! Length and, optionally, angle of (x, y) by CORDIC vectoring.
+/*! The vector is folded into the first octant without changing its 
+	length (the atan2 OCTANTIFY rotates by 45 degrees, which would) and 
+	scaled to [2^28, 2^29) so the 15 rotations keep 28 bits.
+*/
+static inline uint cordicPolar(int x, int y, uint *phi)
+{
+	uint ax= x<0 ? -(uint)x : x, ay= y<0 ? -(uint)y : y, t;
+	int i, s, yy, dphi= 0;
+	bool swap= ax < ay;
+
+	if(swap)
+	{	t= ax; ax= ay; ay= t;	}
+
+	if(ax == 0)
+	{
+		if(phi)
+			*phi= 0;
+		return 0;
+	}
+
+	s= __builtin_clz(ax) - 3;
+	if(s >= 0)
+	{	ax <<= s;	ay <<= s;	}
+	else
+	{	ax >>= -s;	ay >>= -s;	}
+
+	yy= ay;
+	for(i=1; i<CORDICLUT_SIZE; i++)
+	{
+		if(yy >= 0)
+		{
+			t= ax + (yy>>i);
+			yy -= ax>>i;
+			dphi += cordicLUT[i];
+		}
+		else
+		{
+			t= ax - (yy>>i);
+			yy += ax>>i;
+			dphi -= cordicLUT[i];
+		}
+		ax= t;
+	}
+
+	if(phi)
+	{
+		uint p= (dphi+2)>>2;
+		if(swap)	p= BRAD_HPI - p;
+		if(x < 0)	p= BRAD_PI - p;
+		if(y < 0)	p= BRAD_2PI - p;
+		*phi= p & (BRAD_2PI-1);
+	}
+
+	ax= (unsigned long long)ax*CORDIC_INVK >> 32;
+	return s > 0 ? (ax + (1<<s>>1)) >> s : ax << -s;
+}
+
+//! Length of (x, y): within 1 below 2^25, 2^-25 relative beyond.
+uint ihypot(int x, int y)
+{
+	return cordicPolar(x, y, NULL);
+}
+
+//! Cartesian to polar: returns the length, puts the angle in \a phi.
+/*! \a phi is in [0, BRAD_2PI), as atan2 would give it; NULL is fine. */
+uint itopolar(int x, int y, uint *phi)
+{
+	return cordicPolar(x, y, phi);
+}
+
+//! Polar to cartesian: length \a r (any Q) at angle \a phi (brads).
+/*! Results are in the Q of \a r, rounded. Uses the isin() table at 
+	its full Q15, so the error stays near |r|*2^-14.
+*/
+void ifrompolar(int r, int phi, int *x, int *y)
+{
+	const uint QS= SINLUT_PI_SHIFT-1;
+
+	*x= ((long long)r*icosT<QS, SINLUT_FP, 15>(phi) + 0x4000) >> 15;
+	*y= ((long long)r*isinT<QS, SINLUT_FP, 15>(phi) + 0x4000) >> 15;
+}
+
+//! Scale (x, y) to a Q12 unit vector and return its old length.
+/*! A null vector stays null and gives 0. Vectors longer than 2^15 are 
+	shifted down first so x^2+y^2 fits 32 bits; the returned length then 
+	loses the bits shifted out.
+*/
+uint inormalize(int *x, int *y)
+{
+	int vx= *x, vy= *y;
+	uint d, rs, s= 0;
+
+	if(vx == 0 && vy == 0)
+		return 0;
+
+	while(vx >= 1<<15 || vx <= -(1<<15) || vy >= 1<<15 || vy <= -(1<<15))
+	{
+		vx >>= 1;
+		vy >>= 1;
+		s++;
+	}
+
+	d= vx*vx + vy*vy;
+	rs= irsqrt(d);
+	*x= ((long long)vx*rs + (1<<17)) >> 18;
+	*y= ((long long)vy*rs + (1<<17)) >> 18;
+
+	return (uint)(((unsigned long long)d*rs + (1<<29)) >> 30) << s;
+}
+
+//! Square roots of \a n values, same as isqrt() on each.
+void isqrt_n(const uint *in, uint *out, size_t n)
+{
+	for(size_t ii=0; ii<n; ii++)
+		out[ii]= isqrt(in[ii]);
+}
+
+//! Lengths of \a n vectors, same as ihypot() on each.
+void ihypot_n(const int *x, const int *y, uint *out, size_t n)
+{
+	for(size_t ii=0; ii<n; ii++)
+		out[ii]= cordicPolar(x[ii], y[ii], NULL);
+}
+
+//! itopolar() of \a n vectors.
+void itopolar_n(const int *x, const int *y, uint *r, uint *phi, size_t n)
+{
+	for(size_t ii=0; ii<n; ii++)
+		r[ii]= cordicPolar(x[ii], y[ii], &phi[ii]);
+}
+
+//! ifrompolar() of \a n vectors.
+void ifrompolar_n(const int *r, const int *phi, int *x, int *y, size_t n)
+{
+	for(size_t ii=0; ii<n; ii++)
+		ifrompolar(r[ii], phi[ii], &x[ii], &y[ii]);
+}
+
 // EOF
@@ -11,6 +11,8 @@
 #ifndef __TRIG_H__
 #define __TRIG_H__
 
+#include <stddef.h>
+
 // These things may already be present in other headers.
 typedef unsigned int uint;
 
@@ -29,6 +31,27 @@ typedef unsigned int uint;
 static const uint BRAD_PI_SHIFT=14,   BRAD_PI = 1<<BRAD_PI_SHIFT;
 static const uint BRAD_HPI= BRAD_PI/2, BRAD_2PI= BRAD_PI*2; 
 
+// --------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------
+
+typedef uint (*atan2Fn)(int x, int y);
+
+//! An atan2 that trig_init() can put behind iatan2.
+typedef struct TrigAtan2
+{
+	const char *name;
+	atan2Fn fn;
+	uint maxerr;	//!< Worst error in brads for |x|, |y| < 2^15.
+	uint ticks;		//!< Time for trig_init()'s benchmark; 0 if not timed.
+} TrigAtan2;
+
+// --------------------------------------------------------------------
+// GLOBALS
+// --------------------------------------------------------------------
+
+extern atan2Fn iatan2;		//!< The atan2 trig_init() picked.
+
 // --------------------------------------------------------------------
 // PROTOTYPES 
 // --------------------------------------------------------------------
@@ -49,6 +72,27 @@ uint atan2Tonc(int x, int y);
 uint atan2Sin(int x, int y);
 uint atan2Cordic(int x, int y);
 
+const TrigAtan2 *trig_init(uint maxerr);
+const TrigAtan2 *trig_select(const char *name);
+const TrigAtan2 *trig_atan2_list(uint *count);
+
+void isin_n(const int *angles, int *out, size_t n);
+void icos_n(const int *angles, int *out, size_t n);
+void isincos_n(const int *angles, int *sins, int *coss, size_t n);
+void atan2_n(const int *x, const int *y, uint *out, size_t n);
+
+uint isqrt(uint x);
+uint irsqrt(uint x);
+uint ihypot(int x, int y);
+uint itopolar(int x, int y, uint *phi);
+void ifrompolar(int r, int phi, int *x, int *y);
+uint inormalize(int *x, int *y);
+
+void isqrt_n(const uint *in, uint *out, size_t n);
+void ihypot_n(const int *x, const int *y, uint *out, size_t n);
+void itopolar_n(const int *x, const int *y, uint *r, uint *phi, size_t n);
+void ifrompolar_n(const int *r, const int *phi, int *x, int *y, size_t n);
+
 
 #endif // __TRIG_H__
 
@@ -0,0 +1,749 @@
+//
+//  trigbench.cpp : Host benchmark and accuracy check of the atan2s.
+//
+//! \file trigbench.cpp
+//
+/* === NOTES ===
+	Builds trig.cpp twice: once with the generic QDIV, and once with a
+	model of the NDS hardware divider (64/32, no overflow on num<<bits)
+	that also counts the divisions, and aborts if a divide is begun
+	before the last one is collected or collected twice. Each atan2 variant is run over
+	circles of radius 2^2 .. 2^maxbits and checked against libm atan2.
+
+	Columns:
+	  ns/call	host time per call, including an indirect call (and the
+				division counting for the hw model rows).
+	  maxerr	maximum error in brads (PI = 0x4000).
+	  rms		RMS error in brads.
+	  mono		steps along a circle where the result goes backwards
+				while the true angle does not.
+	  div		QDIVs per call.
+	  sw/hw		estimated ARM9 cycles per call spent in QDIV, for
+				libgcc software division and for the hardware divider.
+
+	The cycle figures are a model, not a measurement: see the SWDIV_ and
+	HWDIV_ constants below. Usage: trigbench [maxbits [angles]]
+
+	After that, the _n batch functions are checked against their scalar
+	counterparts and timed per element, and a few triglut.h sine table
+	sizes are compared for accuracy (in Q15 units) against their size.
+
+	Then the roots and vector functions are held against libm over
+	vectors of length 1 .. 2^24: maxerr and rms are in output units,
+	maxrel is the largest relative error, and ns/call is given for both
+	the integer routine and its libm counterpart.
+
+	Last, trig_init() picks an atan2 for a few error bounds (TRIG_ATAN2
+	in the environment overrides that, as it would for any host tool).
+	Each candidate's maxerr in trig.cpp's list is shown next to the one
+	measured here; if any is lower, trigbench says so and exits with 1.
+
+	The generic QDIV overflows on num<<bits: results go wrong from a
+	radius of 2^16 on and the LUT variants index out of their tables
+	beyond 2^18, so generic rows stop at GENERIC_MAXBITS. Up to 2^30 the
+	octant folding itself does not overflow.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "trig.h"
+#include "triglut.h"
+
+// trig.cpp's system headers, included here so they stay out of the
+// namespaces below.
+#if defined(TRIG_NO_SIMD)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// --------------------------------------------------------------------
+// DIVIDER MODELS
+// --------------------------------------------------------------------
+
+// libgcc __divsi3 on the ARM946: call, signs, clz normalisation, and
+// then three cycles per quotient bit.
+#ifndef SWDIV_BASE
+#define SWDIV_BASE			24
+#endif
+#ifndef SWDIV_PER_BIT
+#define SWDIV_PER_BIT		3
+#endif
+
+// DIV_64_32 takes 34 bus cycles = 68 ARM9 cycles. qdivBegin/qdivEnd do
+// five I/O accesses (DIVCNT, NUMER lo/hi, DENOM, a busy poll) plus the
+// result.
+#ifndef HWDIV_LATENCY
+#define HWDIV_LATENCY		68
+#endif
+#ifndef HWDIV_IO
+#define HWDIV_IO			(6*4)
+#endif
+
+// ARM9 cycles of atan2_n's polynomial and octant fold, which the
+// pipelined divide runs under.
+#ifndef HWDIV_OVERLAP
+#define HWDIV_OVERLAP		40
+#endif
+
+#define GENERIC_MAXBITS		18
+#define MAXBITS				30
+
+static unsigned long long qdivCalls, qdivSwCycles, qdivHwCycles;
+
+// The one divider: its result and whether it's in use.
+static int qdivResult;
+static bool qdivBusy;
+
+//! Start a divide on the model divider, like REG_DIV_NUMER/DENOM would.
+static inline void qdivModelBegin(int num, int den, int bits)
+{
+	if(qdivBusy)
+	{
+		fprintf(stderr, "qdivBegin with a divide in flight\n");
+		abort();
+	}
+	qdivBusy= true;
+
+	long long q= den ? ((long long)num<<bits)/den : 0;
+	unsigned long long uq= q<0 ? -q : q;
+	int qbits= 0;
+
+	while(uq)
+	{
+		uq >>= 1;
+		qbits++;
+	}
+
+	qdivCalls++;
+	qdivSwCycles += SWDIV_BASE + SWDIV_PER_BIT*qbits;
+	qdivHwCycles += HWDIV_LATENCY + HWDIV_IO;
+
+	qdivResult= (int)q;
+}
+
+//! Collect the model divider's result.
+static inline int qdivModelEnd()
+{
+	if(!qdivBusy)
+	{
+		fprintf(stderr, "qdivEnd without a divide\n");
+		abort();
+	}
+	qdivBusy= false;
+
+	return qdivResult;
+}
+
+namespace generic
+{
+#include "trig.cpp"
+}
+
+#define TRIG_QDIV
+namespace hwdiv
+{
+static inline void qdivBegin(int num, int den, int bits)
+{	qdivModelBegin(num, den, bits);							}
+
+static inline int qdivEnd()
+{	return qdivModelEnd();									}
+
+#include "trig.cpp"
+}
+
+
+// --------------------------------------------------------------------
+// BENCHMARK
+// --------------------------------------------------------------------
+
+struct Variant
+{
+	const char *name;
+	atan2Fn generic, hwdiv;
+};
+
+#define VARIANT(_f)	{ #_f, generic::_f, hwdiv::_f },
+
+static const Variant variants[]=
+{
+	VARIANT(atan2Null)
+	VARIANT(atan2Oct)
+	VARIANT(atan2OctDiv)
+	VARIANT(atan2Lookup)
+	VARIANT(atan2Lerp)
+	VARIANT(atan2InvLerp)
+	VARIANT(atan2Taylor)
+	VARIANT(atan2Gba)
+	VARIANT(atan2Tonc)
+	VARIANT(atan2Sin)
+	VARIANT(atan2Cordic)
+};
+
+struct Result
+{
+	double ns, maxerr, rms;
+	double calls;		//!< Calls made, for the QDIV counters.
+	uint mono;
+};
+
+static int *ptX, *ptY;
+static double *ptRef;
+static uint ptCount, ptAngles;
+
+//! Wrap a difference in brads to [-PI, PI).
+static inline double bradWrap(double d)
+{
+	d= fmod(d + BRAD_PI, BRAD_2PI);
+	return (d<0 ? d+BRAD_2PI : d) - BRAD_PI;
+}
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+//! Build the points: \a angles steps along circles of radius 2^2 .. 2^maxbits.
+static void buildPoints(uint maxbits, uint angles)
+{
+	uint ii, ir, ia;
+
+	ptAngles= angles;
+	ptCount= (maxbits-1)*angles;
+	ptX= (int*)malloc(ptCount*sizeof(int));
+	ptY= (int*)malloc(ptCount*sizeof(int));
+	ptRef= (double*)malloc(ptCount*sizeof(double));
+
+	for(ir=2, ii=0; ir<=maxbits; ir++)
+	{
+		double r= ldexp(1.0, ir);
+		for(ia=0; ia<angles; ia++, ii++)
+		{
+			double a= 2*M_PI*ia/angles;
+			ptX[ii]= (int)lround(r*cos(a));
+			ptY[ii]= (int)lround(r*sin(a));
+			ptRef[ii]= bradWrap(atan2(ptY[ii], ptX[ii])*BRAD_PI/M_PI);
+		}
+	}
+}
+
+//! Check and time \a fn on the first \a count points.
+static Result runVariant(atan2Fn fn, uint count)
+{
+	Result res= { 0, 0, 0, 0, 0 };
+	uint ii, rep, reps= 1 + 4000000/count;
+	uint sum= 0;
+	double t0, err2= 0;
+
+	for(ii=0; ii<count; ii++)
+	{
+		uint phi= fn(ptX[ii], ptY[ii]);
+		double err= bradWrap(phi - ptRef[ii]);
+
+		if(fabs(err) > res.maxerr)
+			res.maxerr= fabs(err);
+		err2 += err*err;
+
+		if(ii % ptAngles)
+		{
+			uint prev= fn(ptX[ii-1], ptY[ii-1]);
+			res.calls++;
+			if(bradWrap((double)phi - prev) < 0 && bradWrap(ptRef[ii]-ptRef[ii-1]) >= 0)
+				res.mono++;
+		}
+	}
+	res.rms= sqrt(err2/count);
+	res.calls += count + (double)reps*count;
+
+	t0= nsNow();
+	for(rep=0; rep<reps; rep++)
+		for(ii=0; ii<count; ii++)
+			sum += fn(ptX[ii], ptY[ii]);
+	res.ns= (nsNow()-t0)/((double)reps*count);
+
+	// Keep the loop alive.
+	if(sum == 0x12345678)
+		puts("");
+
+	return res;
+}
+
+//! Check the _n functions against the scalar ones and time both.
+static void runBatch(uint atanCount)
+{
+	const uint count= 0x10000;
+	int *angles= (int*)malloc(count*sizeof(int));
+	int *sins= (int*)malloc(count*sizeof(int));
+	int *coss= (int*)malloc(count*sizeof(int));
+	uint *phis= (uint*)malloc(ptCount*sizeof(uint));
+	uint ii, rep, reps, bad, sum= 0;
+	unsigned long long calls;
+	int stall;
+	double t0, tScalar, tBatch;
+
+	// All angles twice over, negative ones included, then random ones.
+	srand(1);
+	for(ii=0; ii<count; ii++)
+		angles[ii]= ii < count/2 ? (int)ii - BRAD_2PI : (rand()<<16) ^ rand();
+
+	bad= 0;
+	generic::isincos_n(angles, sins, coss, count);
+	for(ii=0; ii<count; ii++)
+		bad += (sins[ii] != generic::isin(angles[ii])) + (coss[ii] != generic::icos(angles[ii]));
+	generic::isin_n(angles, sins, count);
+	generic::icos_n(angles, coss, count);
+	for(ii=0; ii<count; ii++)
+		bad += (sins[ii] != generic::isin(angles[ii])) + (coss[ii] != generic::icos(angles[ii]));
+	printf("\nisin_n/icos_n/isincos_n: %u mismatches in %u angles\n", bad, count);
+
+	bad= 0;
+	generic::atan2_n(ptX, ptY, phis, atanCount);
+	for(ii=0; ii<atanCount; ii++)
+		bad += phis[ii] != generic::atan2Tonc(ptX[ii], ptY[ii]);
+	printf("atan2_n: %u mismatches with atan2Tonc in %u points\n", bad, atanCount);
+
+	// Pipelined on the divider model, which has no overflow: one divide 
+	// per pair, HWDIV_OVERLAP cycles of which are hidden.
+	bad= 0;
+	qdivCalls= 0;
+	hwdiv::atan2_n(ptX, ptY, phis, ptCount);
+	calls= qdivCalls;
+	for(ii=0; ii<ptCount; ii++)
+		bad += phis[ii] != hwdiv::atan2Tonc(ptX[ii], ptY[ii]);
+	stall= HWDIV_LATENCY > HWDIV_OVERLAP ? HWDIV_LATENCY - HWDIV_OVERLAP : 0;
+	printf("atan2_n (hw model): %u mismatches in %u points, %.2f div, "
+		"%d hw cyc per divide (%d unpipelined)\n", bad, ptCount, 
+		(double)calls/ptCount, HWDIV_IO + stall, HWDIV_LATENCY + HWDIV_IO);
+
+	// Shuffle the points, sorted along circles the branches predict too well.
+	for(ii=atanCount-1; ii>0; ii--)
+	{
+		uint jj= rand() % (ii+1);
+		int tx= ptX[ii], ty= ptY[ii];
+		ptX[ii]= ptX[jj];	ptY[ii]= ptY[jj];
+		ptX[jj]= tx;		ptY[jj]= ty;
+	}
+
+	reps= 1 + 4000000/count;
+	t0= nsNow();
+	for(rep=0; rep<reps; rep++)
+		for(ii=0; ii<count; ii++)
+			sins[ii]= generic::isin(angles[ii]+rep);
+	tScalar= nsNow()-t0;
+	sum += sins[rep % count];
+	t0= nsNow();
+	for(rep=0; rep<reps; rep++)
+	{
+		angles[rep % count] += rep;
+		generic::isin_n(angles, sins, count);
+	}
+	tBatch= nsNow()-t0;
+	sum += sins[rep % count];
+	printf("isin   %6.2f ns, isin_n  %6.2f ns per element\n",
+		tScalar/reps/count, tBatch/reps/count);
+
+	reps= 1 + 4000000/atanCount;
+	t0= nsNow();
+	for(rep=0; rep<reps; rep++)
+		for(ii=0; ii<atanCount; ii++)
+			phis[ii]= generic::atan2Tonc(ptX[ii], ptY[ii]+(rep&1));
+	tScalar= nsNow()-t0;
+	sum += phis[rep % atanCount];
+	t0= nsNow();
+	for(rep=0; rep<reps; rep++)
+	{
+		ptY[rep % atanCount] ^= rep&1;
+		generic::atan2_n(ptX, ptY, phis, atanCount);
+	}
+	tBatch= nsNow()-t0;
+	sum += phis[rep % atanCount];
+	printf("atan2Tonc %6.2f ns, atan2_n %6.2f ns per element\n",
+		tScalar/reps/atanCount, tBatch/reps/atanCount);
+
+	if(sum == 0x12345678)
+		puts("");
+
+	free(angles);
+	free(sins);
+	free(coss);
+	free(phis);
+}
+
+
+// --------------------------------------------------------------------
+// LUT SIZES
+// --------------------------------------------------------------------
+
+template<uint QS, uint FP>
+static void runLutSize()
+{
+	double err, maxerr= 0, sumsq= 0;
+	uint x;
+
+	for(x=0; x<BRAD_2PI; x++)
+	{
+		err= isinT<QS, FP, 15>(x) - sin(x*M_PI/BRAD_PI)*32768;
+		sumsq += err*err;
+		if(fabs(err) > maxerr)
+			maxerr= fabs(err);
+	}
+	printf("SinLut<%2u,%2u> %6u bytes %8.2f %8.3f\n", QS, FP,
+		(uint)sizeof(SinLut<QS, FP>), maxerr, sqrt(sumsq/BRAD_2PI));
+}
+
+static void runLutSizes()
+{
+	printf("%-13s %12s %8s %8s\n", "table", "", "maxerr", "rms");
+	runLutSize<4, 15>();
+	runLutSize<5, 15>();
+	runLutSize<7, 15>();
+	runLutSize<7, 16>();
+	runLutSize<10, 16>();
+}
+
+
+// --------------------------------------------------------------------
+// ROOTS AND VECTORS
+// --------------------------------------------------------------------
+
+static const uint MATH_COUNT= 0x10000;
+
+//! Error statistics against libm.
+struct ErrStat
+{
+	double maxerr, sumsq, maxrel;
+	uint count;
+
+	ErrStat() : maxerr(0), sumsq(0), maxrel(0), count(0)	{}
+
+	void add(double val, double ref)
+	{
+		double err= fabs(val - ref);
+		if(err > maxerr)
+			maxerr= err;
+		if(ref != 0 && err/fabs(ref) > maxrel)
+			maxrel= err/fabs(ref);
+		sumsq += err*err;
+		count++;
+	}
+};
+
+static void printMath(const char *name, const ErrStat &es, double ns, double nsLibm)
+{
+	printf("%-13s %8.2f %8.2f %8.3f %8.3f %10.2e\n", name, ns, nsLibm, 
+		es.maxerr, sqrt(es.sumsq/es.count), es.maxrel);
+}
+
+//! Log-uniform in [1, 2^bits), random sign if \a sign.
+static int randLog(uint bits, bool sign)
+{
+	double v= exp2(bits*(rand()/(RAND_MAX+1.0)));
+	return (sign && (rand() & 1)) ? -(int)v : (int)v;
+}
+
+static void runMath()
+{
+	const uint count= MATH_COUNT;
+	int *vx= (int*)malloc(count*sizeof(int));
+	int *vy= (int*)malloc(count*sizeof(int));
+	uint *ua= (uint*)malloc(count*sizeof(uint));
+	uint *ub= (uint*)malloc(count*sizeof(uint));
+	int *sa= (int*)malloc(count*sizeof(int));
+	int *sb= (int*)malloc(count*sizeof(int));
+	uint ii, rep, bad, sum= 0;
+	const uint reps= 16;
+	double t0, ns, nsLibm, dsum= 0;
+
+	srand(2);
+	for(ii=0; ii<count; ii++)
+	{
+		ua[ii]= ii < 0x1000 ? ii : (uint)randLog(32, false) + (rand() & 0xFF);
+		vx[ii]= randLog(24, true);
+		vy[ii]= rand() & 7 ? randLog(24, true) : rand() % 5 - 2;
+	}
+
+	printf("\n%-13s %8s %8s %8s %8s %10s\n", "function", "ns/call", "libm ns", 
+		"maxerr", "rms", "maxrel");
+
+	// isqrt vs sqrt, rounded down.
+	{
+		ErrStat es;
+		for(ii=0; ii<count; ii++)
+			es.add(generic::isqrt(ua[ii]), floor(sqrt((double)ua[ii])));
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += generic::isqrt(ua[ii]+rep);
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += (uint)sqrt((double)(ua[ii]+rep));
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("isqrt", es, ns, nsLibm);
+	}
+
+	// irsqrt vs 2^30/sqrt.
+	{
+		ErrStat es;
+		for(ii=0; ii<count; ii++)
+			if(ua[ii])
+				es.add(generic::irsqrt(ua[ii]), 1073741824.0/sqrt((double)ua[ii]));
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += generic::irsqrt(ua[ii]+rep);
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += (uint)(1073741824.0/sqrt((double)(ua[ii]+rep)));
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("irsqrt", es, ns, nsLibm);
+	}
+
+	// ihypot vs hypot.
+	{
+		ErrStat es;
+		for(ii=0; ii<count; ii++)
+			es.add(generic::ihypot(vx[ii], vy[ii]), hypot(vx[ii], vy[ii]));
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += generic::ihypot(vx[ii]+rep, vy[ii]);
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				dsum += hypot(vx[ii]+rep, vy[ii]);
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("ihypot", es, ns, nsLibm);
+	}
+
+	// itopolar vs hypot+atan2; the angle error is in brads.
+	{
+		ErrStat er, ep;
+		uint phi;
+		for(ii=0; ii<count; ii++)
+		{
+			er.add(generic::itopolar(vx[ii], vy[ii], &phi), hypot(vx[ii], vy[ii]));
+			if(vx[ii] || vy[ii])
+			{
+				double ref= atan2(vy[ii], vx[ii])*BRAD_PI/M_PI;
+				ep.add(ref + bradWrap(phi - ref), ref);
+			}
+		}
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				sum += generic::itopolar(vx[ii]+rep, vy[ii], &phi) + phi;
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+				dsum += hypot(vx[ii]+rep, vy[ii]) + atan2(vy[ii], vx[ii]+rep);
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("itopolar r", er, ns, nsLibm);
+		printMath("itopolar phi", ep, ns, nsLibm);
+	}
+
+	// ifrompolar vs r*cos, r*sin.
+	{
+		ErrStat es;
+		int x, y;
+		for(ii=0; ii<count; ii++)
+		{
+			double a= vy[ii]*M_PI/BRAD_PI;
+			generic::ifrompolar(vx[ii], vy[ii], &x, &y);
+			es.add(x, vx[ii]*cos(a));
+			es.add(y, vx[ii]*sin(a));
+		}
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+			{
+				generic::ifrompolar(vx[ii], vy[ii]+rep, &x, &y);
+				sum += x+y;
+			}
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+			{
+				double a= (vy[ii]+rep)*M_PI/BRAD_PI;
+				dsum += vx[ii]*cos(a) + vx[ii]*sin(a);
+			}
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("ifrompolar", es, ns, nsLibm);
+	}
+
+	// inormalize vs x/hypot, in Q12.
+	{
+		ErrStat es;
+		int x, y;
+		for(ii=0; ii<count; ii++)
+		{
+			double h= hypot(vx[ii], vy[ii]);
+			x= vx[ii];	y= vy[ii];
+			generic::inormalize(&x, &y);
+			if(h != 0)
+			{
+				es.add(x, vx[ii]*4096.0/h);
+				es.add(y, vy[ii]*4096.0/h);
+			}
+		}
+
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+			{
+				x= vx[ii]+rep;	y= vy[ii];
+				sum += generic::inormalize(&x, &y) + x + y;
+			}
+		ns= (nsNow()-t0)/reps/count;
+		t0= nsNow();
+		for(rep=0; rep<reps; rep++)
+			for(ii=0; ii<count; ii++)
+			{
+				double h= hypot(vx[ii]+rep, vy[ii]);
+				dsum += (vx[ii]+rep)*4096.0/h + vy[ii]*4096.0/h;
+			}
+		nsLibm= (nsNow()-t0)/reps/count;
+		printMath("inormalize", es, ns, nsLibm);
+	}
+
+	// The _n versions give what the scalar ones give.
+	bad= 0;
+	generic::isqrt_n(ua, ub, count);
+	for(ii=0; ii<count; ii++)
+		bad += ub[ii] != generic::isqrt(ua[ii]);
+	generic::ihypot_n(vx, vy, ub, count);
+	for(ii=0; ii<count; ii++)
+		bad += ub[ii] != generic::ihypot(vx[ii], vy[ii]);
+	generic::itopolar_n(vx, vy, ua, ub, count);
+	for(ii=0; ii<count; ii++)
+	{
+		uint phi, r= generic::itopolar(vx[ii], vy[ii], &phi);
+		bad += ua[ii] != r || ub[ii] != phi;
+	}
+	generic::ifrompolar_n(vx, vy, sa, sb, count);
+	for(ii=0; ii<count; ii++)
+	{
+		int x, y;
+		generic::ifrompolar(vx[ii], vy[ii], &x, &y);
+		bad += sa[ii] != x || sb[ii] != y;
+	}
+	printf("isqrt_n/ihypot_n/itopolar_n/ifrompolar_n: %u mismatches\n", bad);
+
+	if(sum == 0x12345678 || dsum == 1)
+		puts("");
+
+	free(vx);
+	free(vy);
+	free(ua);
+	free(ub);
+	free(sa);
+	free(sb);
+}
+
+
+// --------------------------------------------------------------------
+// DISPATCH
+// --------------------------------------------------------------------
+
+//! What trig_init() picks for a few error bounds, and its timings.
+//! The list's error bounds must cover what was measured above, with 
+//! either QDIV (\a measured, by variant); returns how many don't.
+static uint runDispatch(const double *measured)
+{
+	static const uint bounds[]= { 0, 1, 3, 8, 200 };
+	const TrigAtan2 *list, *ta;
+	uint ii, jj, count, low= 0;
+
+	printf("\n%-13s %s\n", "trig_init", "pick");
+	for(ii=0; ii<countof(bounds); ii++)
+	{
+		ta= generic::trig_init(bounds[ii]);
+		printf("maxerr <= %-4u %s\n", bounds[ii], ta->name);
+	}
+
+	list= generic::trig_atan2_list(&count);
+	printf("%-13s %8s %8s %8s\n", "candidate", "maxerr", "ticks", "measured");
+	for(ii=0; ii<count; ii++)
+	{
+		printf("%-13s %8u %8u", list[ii].name, list[ii].maxerr, list[ii].ticks);
+		for(jj=0; jj<countof(variants); jj++)
+		{
+			if(strcmp(variants[jj].name, list[ii].name) != 0)
+				continue;
+			printf(" %8.1f", measured[jj]);
+			if(measured[jj] > list[ii].maxerr)
+			{
+				printf("  bound too low");
+				low++;
+			}
+		}
+		printf("\n");
+	}
+	return low;
+}
+
+int main(int argc, char *argv[])
+{
+	uint maxbits= argc>1 ? atoi(argv[1]) : 15;
+	uint angles= argc>2 ? atoi(argv[2]) : 4096;
+	uint ii, genCount;
+	double measured[countof(variants)];
+
+	if(maxbits < 2 || maxbits > MAXBITS || angles < 2)
+	{
+		fprintf(stderr, "usage: trigbench [maxbits (2-%d) [angles]]\n", MAXBITS);
+		return 1;
+	}
+
+	buildPoints(maxbits, angles);
+	genCount= ((maxbits < GENERIC_MAXBITS ? maxbits : GENERIC_MAXBITS)-1)*angles;
+
+	printf("radius 2^2 .. 2^%u, %u angles, %u points\n", maxbits, angles, ptCount);
+	if(genCount < ptCount)
+		printf("generic QDIV only up to 2^%d\n", GENERIC_MAXBITS);
+	printf("%-13s %-8s %8s %8s %8s %6s %6s %8s %8s\n", "variant", "QDIV",
+		"ns/call", "maxerr", "rms", "mono", "div", "sw cyc", "hw cyc");
+
+	for(ii=0; ii<countof(variants); ii++)
+	{
+		const Variant *v= &variants[ii];
+		Result rg= runVariant(v->generic, genCount);
+
+		qdivCalls= qdivSwCycles= qdivHwCycles= 0;
+		Result rh= runVariant(v->hwdiv, ptCount);
+
+		printf("%-13s %-8s %8.2f %8.1f %8.2f %6u\n", v->name, "generic",
+			rg.ns, rg.maxerr, rg.rms, rg.mono);
+		printf("%-13s %-8s %8.2f %8.1f %8.2f %6u %6.2f %8.1f %8.1f\n", "", "hw model",
+			rh.ns, rh.maxerr, rh.rms, rh.mono, qdivCalls/rh.calls,
+			qdivSwCycles/rh.calls, qdivHwCycles/rh.calls);
+		measured[ii]= rg.maxerr > rh.maxerr ? rg.maxerr : rh.maxerr;
+	}
+
+	// atan2_n matches atan2Tonc where the generic QDIV doesn't overflow.
+	runBatch(((maxbits < 15 ? maxbits : 15)-1)*angles);
+	runLutSizes();
+	runMath();
+
+	return runDispatch(measured) ? 1 : 0;
+}
+
+// EOF
@@ -0,0 +1,273 @@
+//
+//  triglut.h : Compile-time generated trig LUTs.
+//
+//! \file triglut.h
+//
+/* === NOTES ===
+	The tables are built by constexpr code (C++14), so there is no data
+	to keep in sync with the code. They're parameterised by size and
+	precision:
+
+	  SinLut<QS, FP>	sine over [0, PI/2] in 2^QS steps, Q(FP) values.
+	  TanLut<QS, FP>	tangent over [0, PI/2] in 2^QS steps, Q(FP) values,
+						clamped to TANLUT_MAX (like tan(PI/2) always was).
+	  AtanLut<AS, FP>	arctangent over [0, 1] in 2^AS steps, PI/4 = 1<<FP.
+	  RsqrtLut<RB>		1/sqrt(m) seeds for m in [1/4, 1), indexed by the
+						top RB bits of m; Q15 values.
+
+	Each table has two entries past the interval so interpolation never
+	needs a bounds check. Only instantiated tables end up in the binary;
+	isinT(), icosT() and itanT() instantiate the one they use.
+
+	SinLut<7,15>, TanLut<7,16> and AtanLut<7,15> are trig.cpp's sinLUT,
+	tanLUT and atanLUT, bit for bit. A tiny SinLut<4,15> (36 bytes) stays
+	in the ARM9 cache for wobbles; SinLut<10,16> (4 kB) is for oscillators
+	that have to sound clean.
+*/
+
+#ifndef __TRIGLUT_H__
+#define __TRIGLUT_H__
+
+#include "trig.h"
+
+// --------------------------------------------------------------------
+// CONSTEXPR MATH (generators only)
+// --------------------------------------------------------------------
+
+static constexpr double LUT_PI= 3.14159265358979323846;
+static constexpr double TANLUT_MAX= 400.0;
+
+//! sin(x) by Taylor series. Good to double precision for |x| <= PI.
+constexpr double lutSin(double x)
+{
+	double term= x, sum= x;
+	for(int i=1; i<24; i++)
+	{
+		term *= -x*x/((2*i)*(2*i+1));
+		sum += term;
+	}
+	return sum;
+}
+
+//! cos(x) by Taylor series. Good to double precision for |x| <= PI.
+constexpr double lutCos(double x)
+{
+	double term= 1, sum= 1;
+	for(int i=1; i<24; i++)
+	{
+		term *= -x*x/((2*i-1)*(2*i));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double lutSqrt(double x)
+{
+	double r= x > 1 ? x : 1;
+	for(int i=0; i<64; i++)
+		r= (r + x/r)/2;
+	return r;
+}
+
+//! atan(x) for x >= 0: three halvings of the angle, then Taylor.
+constexpr double lutAtan(double x)
+{
+	for(int i=0; i<3; i++)
+		x= x/(1 + lutSqrt(1 + x*x));
+
+	double sum= 0, term= x, x2= x*x;
+	for(int i=0; i<40; i++)
+	{
+		sum += term/(2*i+1);
+		term *= -x2;
+	}
+	return 8*sum;
+}
+
+//! Round to nearest, for positive values.
+constexpr unsigned int lutRound(double x)
+{
+	return (unsigned int)(x + 0.5);
+}
+
+//! Smallest type for a table with values up to 2^bits (inclusive).
+template<bool fits16> struct LutType			{	typedef unsigned int type;		};
+template<> struct LutType<true>				{	typedef unsigned short type;	};
+
+// --------------------------------------------------------------------
+// TABLES
+// --------------------------------------------------------------------
+
+//! Sine table, [0, PI/2] in 2^QS steps, Q(FP).
+template<uint QS, uint FP>
+struct ALIGN(4) SinLut
+{
+	static_assert(QS>=2 && QS<=BRAD_PI_SHIFT-1, "SinLut: QS out of range");
+	static_assert(FP<=16, "SinLut: FP too large for the interpolation");
+
+	typedef typename LutType<(FP<16)>::type value_type;
+	static constexpr uint SIZE= (1<<QS)+2;
+
+	value_type data[SIZE];
+
+	constexpr SinLut() : data()
+	{
+		for(uint i=0; i<SIZE; i++)
+			data[i]= lutRound(lutSin(LUT_PI/2*i/(1<<QS))*(1<<FP));
+	}
+
+	constexpr value_type operator[](uint i) const	{	return data[i];	}
+};
+
+//! Tangent table, [0, PI/2] in 2^QS steps, Q(FP), at most TANLUT_MAX.
+template<uint QS, uint FP>
+struct ALIGN(4) TanLut
+{
+	static_assert(QS>=2 && QS<=BRAD_PI_SHIFT-1, "TanLut: QS out of range");
+	static_assert(FP<=22, "TanLut: FP too large for TANLUT_MAX");
+
+	typedef unsigned int value_type;
+	static constexpr uint SIZE= (1<<QS)+2;
+
+	value_type data[SIZE];
+
+	constexpr TanLut() : data()
+	{
+		for(uint i=0; i<SIZE; i++)
+		{
+			double a= LUT_PI/2*i/(1<<QS);
+			double c= lutCos(a);
+			double t= c*TANLUT_MAX > lutSin(a) ? lutSin(a)/c : TANLUT_MAX;
+			data[i]= lutRound(t*(1<<FP));
+		}
+	}
+
+	constexpr value_type operator[](uint i) const	{	return data[i];	}
+};
+
+//! Arctangent table, [0, 1] in 2^AS steps; PI/4 = 1<<FP.
+template<uint AS, uint FP>
+struct ALIGN(4) AtanLut
+{
+	static_assert(AS>=2 && AS<=12, "AtanLut: AS out of range");
+	static_assert(FP<=16, "AtanLut: FP too large");
+
+	typedef typename LutType<(FP<16)>::type value_type;
+	static constexpr uint SIZE= (1<<AS)+2;
+
+	value_type data[SIZE];
+
+	constexpr AtanLut() : data()
+	{
+		for(uint i=0; i<SIZE; i++)
+			data[i]= lutRound(lutAtan((double)i/(1<<AS))*4/LUT_PI*(1<<FP));
+	}
+
+	constexpr value_type operator[](uint i) const	{	return data[i];	}
+};
+
+//! Reciprocal square root seeds, m in [1/4, 1) in 2^-RB steps, Q15.
+/*! Entry i is 1/sqrt(m) for the middle of [i, i+1)*2^-RB, offset by
+	the 2^(RB-2) indices below 1/4.
+*/
+template<uint RB>
+struct ALIGN(4) RsqrtLut
+{
+	static_assert(RB>=3 && RB<=10, "RsqrtLut: RB out of range");
+
+	typedef unsigned short value_type;
+	static constexpr uint BASE= 1<<(RB-2), SIZE= 3<<(RB-2);
+
+	value_type data[SIZE];
+
+	constexpr RsqrtLut() : data()
+	{
+		for(uint i=0; i<SIZE; i++)
+			data[i]= lutRound((1<<15)/lutSqrt((BASE+i+0.5)/(1<<RB)));
+	}
+
+	constexpr value_type operator[](uint i) const	{	return data[i];	}
+};
+
+//! The one instance of each table.
+template<uint QS, uint FP> constexpr SinLut<QS, FP> sinLut{};
+template<uint QS, uint FP> constexpr TanLut<QS, FP> tanLut{};
+template<uint AS, uint FP> constexpr AtanLut<AS, FP> atanLut{};
+template<uint RB> constexpr RsqrtLut<RB> rsqrtLut{};
+
+// --------------------------------------------------------------------
+// FUNCTIONS
+// --------------------------------------------------------------------
+
+//! Sine from a SinLut<QS, FP>, as a Q(OUT) number.
+/*! Same method as isin(), which is isinT<7, 15, 12>.
+	\param x	Angle, with 0x8000 for a full circle.
+*/
+template<uint QS, uint FP, uint OUT>
+inline int isinT(int x)
+{
+	static_assert(OUT<=FP, "isinT: OUT exceeds table precision");
+
+	const uint strideShift= BRAD_PI_SHIFT-1-QS, hpi= 1<<QS;
+	const SinLut<QS, FP> &lut= sinLut<QS, FP>;
+	int h, ya, yb, y;
+	uint ux, quad;
+
+	ux= (uint)x%BRAD_2PI;
+	h= ux & ((1<<strideShift)-1);
+	quad= ux>>strideShift>>QS;
+	ux= ux>>strideShift & (hpi-1);
+
+	if(quad & 1)
+	{
+		ya= lut[hpi-ux  ];
+		yb= lut[hpi-ux-1];
+	}
+	else
+	{
+		ya= lut[ux  ];
+		yb= lut[ux+1];
+	}
+
+	y= (ya + ((yb-ya)*h >> strideShift))>>(FP-OUT);
+	return (quad & 2) ? -y : +y;
+}
+
+//! Cosine from a SinLut<QS, FP>, as a Q(OUT) number.
+template<uint QS, uint FP, uint OUT>
+inline int icosT(int x)
+{
+	return isinT<QS, FP, OUT>(x + BRAD_HPI);
+}
+
+//! Tangent from a TanLut<QS, FP>, as a Q(OUT) number.
+/*! Same method as itan(), which is itanT<7, 16, 12>. */
+template<uint QS, uint FP, uint OUT>
+inline int itanT(int x)
+{
+	static_assert(OUT<=FP, "itanT: OUT exceeds table precision");
+	static_assert(FP<=QS+9, "itanT: interpolation would overflow near PI/2");
+
+	const uint strideShift= BRAD_PI_SHIFT-1-QS, pi= 2<<QS;
+	const TanLut<QS, FP> &lut= tanLut<QS, FP>;
+	uint ux= (uint)x % BRAD_PI;
+	uint xa= ux>>strideShift;
+	int ya, yb, h= ux & ((1<<strideShift)-1);
+
+	if(ux <= BRAD_HPI)
+	{
+		ya= lut[xa  ];
+		yb= lut[xa+1];
+	}
+	else
+	{
+		ya= -lut[pi-xa  ];
+		yb= -lut[pi-xa-1];
+	}
+
+	return (ya + ((yb-ya)*h >> strideShift))>>(FP-OUT);
+}
+
+#endif // __TRIGLUT_H__
+
+// EOF
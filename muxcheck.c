@@ -0,0 +1,180 @@
+//
+//  muxcheck.c : Host model of the sprite multiplexer.
+//
+/* === NOTES ===
+	Runs frames of random sprites through sprites.c and replays what
+	the DS does with the result: restore and commit at VBlank, then the
+	rewrites line by line. A rewrite at line L only counts from line
+	L+SPR_MUX_LEAD on, and until then neither the sprite it replaces nor
+	the new one may be on screen. At every line, each sprite that got a
+	slot must be in it, and nothing else may be visible. After the last
+	line and the next restore, OAM must match the shadow again.
+
+	Prints how many sprites were shown, and the rewrites and VCount
+	IRQs it took, for sprites spread over the screen and for sprites
+	crowded into a band; then the band again with the flicker scheduler
+	on, where no line may go over SPR_LINE_CYCLES either.
+
+	Usage: muxcheck [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sprites.h"
+#include "platform.h"
+
+static SprOam spr;
+static u16 hw[SPR_COUNT*4];			// what the DS would have in OAM
+static u32 lcg= 1;
+static long errors;
+
+static int rnd(int n)
+{
+	lcg= lcg*1664525 + 1013904223;
+	return (lcg>>8) % n;
+}
+
+static bool covers(const u16 *e, int line)
+{
+	return !(e[0] & (1<<9)) && ((line - (e[0] & 0xFF)) & 0xFF) < SPR_SIZE;
+}
+
+static void fail(int frame, int line, const char *what, int slot)
+{
+	if(errors++ < 10)
+		printf("frame %d line %d slot %d: %s\n", frame, line, slot, what);
+}
+
+static void vblank()
+{
+	const SprMux *m= sprMux(&spr);
+	int i, first, n;
+
+	for(i=0; i<m->restores; i++)
+		memcpy(&hw[m->restore[i].slot*4], m->restore[i].attr, 6);
+	for(i=0; i<SPR_COUNT; i++)
+		if(!(spr.dirty[i>>5] & 1u<<(i&31)) && memcmp(&hw[i*4], &spr.oam[i*4], 6) != 0)
+			fail(-1, -1, "not dirty but differs from the shadow", i);
+	n= sprDirtySpan(&spr, &first);
+	memcpy(&hw[first*4], &spr.oam[first*4], n*8);
+	sprClean(&spr);
+}
+
+//! Beam through the frame just committed.
+static void scanFrame(int frame, int *lines)
+{
+	const SprMux *m= sprMux(&spr);
+	int line, i, k, cycles, next= 0, last= -1;
+
+	for(line=0; line<SCREEN_H; line++)
+	{
+		while(next < m->count && m->rw[next].line + SPR_MUX_LEAD <= line)
+		{
+			memcpy(&hw[m->rw[next].slot*4], m->rw[next].attr, 6);
+			if(m->rw[next].line != last)
+				(*lines)++;
+			last= m->rw[next].line;
+			next++;
+		}
+
+		// In flight: slot neither old nor new may show.
+		for(k=next; k<m->count && m->rw[k].line <= line; k++)
+		{
+			if(covers(&hw[m->rw[k].slot*4], line) || covers(m->rw[k].attr, line))
+				fail(frame, line, "rewrite while visible", m->rw[k].slot);
+		}
+
+		// Everything with a slot is in it...
+		cycles= 0;
+		for(i=0; i<spr.count; i++)
+		{
+			const SprEntry *e= &spr.list[i];
+			if(e->slot >= 0 && covers(e->attr, line) && memcmp(&hw[e->slot*4], e->attr, 6) != 0)
+				fail(frame, line, "sprite missing", e->slot);
+			if(e->slot >= 0 && covers(e->attr, line))
+				cycles += SPR_CYCLES;
+		}
+		if(spr.flicker && cycles > SPR_LINE_CYCLES)
+			fail(frame, line, "over budget", -1);
+		// ...and nothing else shows.
+		for(k=0; k<SPR_COUNT; k++)
+		{
+			if(!covers(&hw[k*4], line))
+				continue;
+			for(i=0; i<spr.count; i++)
+				if(spr.list[i].slot == k && memcmp(&hw[k*4], spr.list[i].attr, 6) == 0)
+					break;
+			if(i == spr.count)
+				fail(frame, line, "stray sprite", k);
+		}
+	}
+}
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+	static const int counts[]= { 64, 128, 160, 256, 384, SPR_MAX };
+	int frames= argc>1 ? atoi(argv[1]) : 200;
+	const int nCounts= sizeof(counts)/sizeof(counts[0]);
+	int c, f, i;
+	int x[SPR_MAX], y[SPR_MAX];
+
+	// First spread over the screen with half of them moving, then all
+	// still in an 80 line band, which is more than fits.
+	printf("%7s %7s %9s %9s %9s %9s\n", "sprites", "shown", "rewrites", "irqs", "ns/end", "errors");
+	for(c=0; c<nCounts*3; c++)
+	{
+		bool band= c >= nCounts;
+		int n= counts[c % nCounts];
+		long shown= 0, rewrites= 0;
+		int lines= 0;
+		double ns= 0;
+
+		sprInit(&spr);
+		spr.flicker= c >= nCounts*2;
+		memset(hw, 0, sizeof(hw));
+		errors= 0;
+		if(c == nCounts)
+			printf("in a band:\n");
+		if(c == nCounts*2)
+			printf("in a band, flickered to fit:\n");
+		for(i=0; i<n; i++)
+		{
+			x[i]= rnd(256+32)-32;
+			y[i]= band ? 64+rnd(48) : rnd(SCREEN_H+31)-31;
+		}
+
+		for(f=0; f<frames; f++)
+		{
+			double t0= nsNow();
+
+			sprBegin(&spr);
+			for(i=0; i<n; i++)
+			{
+				if(!band && (i & 1))
+					y[i]= y[i]+1 >= SCREEN_H ? -31 : y[i]+1;
+				sprAdd(&spr, x[i], y[i], i&3, i&15, i&2);
+			}
+			sprEnd(&spr);
+			ns += nsNow()-t0;
+
+			vblank();
+			scanFrame(f, &lines);
+			shown += spr.count - spr.dropped - spr.flickered;
+			rewrites += sprMux(&spr)->count;
+		}
+		printf("%7d %7.1f %9.1f %9.1f %9.0f %9ld\n", n, (double)shown/frames,
+			(double)rewrites/frames, (double)lines/frames, ns/frames, errors);
+	}
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+//
+//  osc.cpp : Sine oscillator banks.
+//
+// C++ only for mpglib/triglut.h's sine table; the interface is C.
+
+#include "osc.h"
+#include "mpglib/triglut.h"
+
+// Fill a wave with amp*sin() in Q8 pixels, from the Q15 sine table.
+void oscWaveInit(s16 *wave, int amp)
+{
+	for(int i = 0; i < OSC_WAVE_SIZE; i++) {
+		int s = isinT<7, 15, 15>(i << (BRAD_PI_SHIFT+1-OSC_WAVE_BITS));
+		wave[i] = (amp*s*(1<<OSC_FP) + (1<<14)) >> 15;
+	}
+}
@@ -0,0 +1,57 @@
+//
+//  osc.h : Sine oscillator banks for things that bob and wobble.
+//
+/* === NOTES ===
+	A phase is a u32 with 2^32 for a full circle (brads<<17), so it
+	wraps for free. An oscillator's amplitude is baked into its wave: a
+	table of amp*sin() in Q8 pixels, built once from the trig sine LUT.
+	Reading an oscillator is then one lookup, so a ghost that bobs on a
+	bank and wobbles with its x costs two lookups and adds.
+
+	OSC_RAD() converts radians, so sin(t*2.0) with t += 0.05 per frame
+	becomes a phase stepping OSC_RAD(0.1) per frame, and sin(x/20.0) a
+	phase of x*OSC_RAD(1/20.0).
+*/
+
+#ifndef __OSC_H__
+#define __OSC_H__
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_WAVE_BITS	8
+#define OSC_WAVE_SIZE	(1<<OSC_WAVE_BITS)
+#define OSC_FP			8
+
+// Phase for an angle in radians. Only for constants: it's a double.
+#define OSC_RAD(_r)		((u32)((_r)*683565275.5764316 + 0.5))
+#define OSC_QUARTER		0x40000000u
+
+typedef struct OscBank
+{
+	const s16 *wave;	// amp*sin in Q8, from oscWaveInit()
+	u32 phase;			// phase of entity 0
+	u32 step;			// added to phase by oscBankStep()
+} OscBank;
+
+void oscWaveInit(s16 *wave, int amp);
+
+// amp*sin(phase) in Q8 pixels, rounded to the nearest table entry.
+static inline int oscWave(const s16 *wave, u32 phase)
+{
+	return wave[(phase + (1u<<(31-OSC_WAVE_BITS))) >> (32-OSC_WAVE_BITS)];
+}
+
+static inline void oscBankStep(OscBank *bank)
+{
+	bank->phase += bank->step;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __OSC_H__
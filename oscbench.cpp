@@ -0,0 +1,167 @@
+//
+//  oscbench.cpp : Host check of the ghost oscillators against libm.
+//
+/* === NOTES ===
+	Main.c used to place the ghosts with
+	  y = base + sin(t*2.0)*5.0 + sin(x/20.0)*amp	(cos for row b)
+	where t += 0.05 each frame. This runs the same rows through the
+	oscillators, exactly as game.c's drawGhosts() does, and compares the
+	sprite y's with the double versions over a few hours of frames.
+	It also times both per row of 20 ghosts.
+
+	The old float t also drifted: (int)(t*20.0) stops matching the frame
+	count after a while. The count of such frames is shown too; the
+	banks run off an integer tick and don't have that problem.
+
+	Usage: oscbench [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "osc.h"
+
+#define GHOSTS 20
+
+struct Row
+{
+	const char *name;
+	int base, amp;
+	bool cosine;
+};
+
+static const Row rows[]=
+{
+	{ "a (sin, 10)",	167, 10,	false	},
+	{ "b (cos, 10)",	175, 10,	true	},
+	{ "c (sin, 4)",		185, 4,		false	},
+};
+
+static s16 wave4[OSC_WAVE_SIZE], wave5[OSC_WAVE_SIZE], wave10[OSC_WAVE_SIZE];
+
+static double nsNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+//! Ghost 0's x and the spacing for a row at frame \a tick.
+static void rowX(int row, u32 tick, int *x0, int *dx)
+{
+	switch(row)
+	{
+	case 0:	*x0= (int)(tick%60)-32*4;			*dx= 20;	break;
+	case 1:	*x0= 256+32*4-(int)(tick*5/4%60);	*dx= -20;	break;
+	default:*x0= (int)(tick/2%60)-32*4;			*dx= 20;	break;
+	}
+}
+
+//! The old double expression.
+static void rowLibm(int row, u32 tick, int *y)
+{
+	const Row *r= &rows[row];
+	double t= tick*0.05;
+	int x0, dx, i;
+
+	rowX(row, tick, &x0, &dx);
+	for(i=0; i<GHOSTS; i++)
+	{
+		double x= x0 + i*dx;
+		y[i]= r->cosine ?
+			r->base + cos(t*2.3)*5.0 + cos(x/20.0)*r->amp :
+			r->base + sin(t*2.0)*5.0 + sin(x/20.0)*r->amp;
+	}
+}
+
+//! game.c's drawGhosts() for one row, without the platSprite.
+static void rowOsc(int row, u32 tick, const OscBank *bob, int *y)
+{
+	const Row *r= &rows[row];
+	const s16 *wave= r->amp == 4 ? wave4 : wave10;
+	u32 shift= r->cosine ? OSC_QUARTER : 0;
+	int x0, dx, i;
+
+	rowX(row, tick, &x0, &dx);
+	int base= (r->base<<OSC_FP) + oscWave(bob->wave, bob->phase);
+
+	for(i=0; i<GHOSTS; i++)
+	{
+		int x= x0 + i*dx;
+		y[i]= (base + oscWave(wave, (u32)x*OSC_RAD(1/20.0) + shift))>>OSC_FP;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	u32 frames= argc>1 ? atoi(argv[1]) : 60*60*60*4;
+	u32 tick, drift= 0;
+	int row, i, yl[GHOSTS], yo[GHOSTS];
+	unsigned long long off[3]= { 0 }, total= 0;
+	int maxdiff[3]= { 0 };
+	float t= 0;
+
+	oscWaveInit(wave4, 4);
+	oscWaveInit(wave5, 5);
+	oscWaveInit(wave10, 10);
+
+	OscBank bobA= { wave5, 0, OSC_RAD(0.1) };
+	OscBank bobB= { wave5, OSC_QUARTER, OSC_RAD(0.115) };
+
+	for(tick=1; tick<=frames; tick++)
+	{
+		oscBankStep(&bobA);
+		oscBankStep(&bobB);
+		t += 0.05;
+		drift += (int)(t*20.0)%60 != (int)(tick%60);
+
+		for(row=0; row<3; row++)
+		{
+			rowLibm(row, tick, yl);
+			rowOsc(row, tick, row == 1 ? &bobB : &bobA, yo);
+			for(i=0; i<GHOSTS; i++)
+			{
+				int d= abs(yl[i] - yo[i]);
+				off[row] += d != 0;
+				if(d > maxdiff[row])
+					maxdiff[row]= d;
+			}
+		}
+		total += GHOSTS;
+	}
+
+	printf("%u frames, %llu ghosts per row\n", frames, total);
+	printf("%-12s %8s %8s\n", "row", "off by 1", "maxdiff");
+	for(row=0; row<3; row++)
+		printf("%-12s %7.3f%% %8d\n", rows[row].name, 100.0*off[row]/total, maxdiff[row]);
+	printf("float t drifted from the frame count in %.1f%% of frames\n", 100.0*drift/frames);
+
+	// Timing, per row of GHOSTS.
+	const u32 reps= 200000;
+	double t0, nsLibm, nsOsc;
+	long long sum= 0;
+
+	t0= nsNow();
+	for(tick=0; tick<reps; tick++)
+	{
+		rowLibm(tick%3, tick, yl);
+		sum += yl[tick%GHOSTS];
+	}
+	nsLibm= (nsNow()-t0)/reps;
+
+	t0= nsNow();
+	for(tick=0; tick<reps; tick++)
+	{
+		oscBankStep(&bobA);
+		rowOsc(tick%3, tick, &bobA, yo);
+		sum += yo[tick%GHOSTS];
+	}
+	nsOsc= (nsNow()-t0)/reps;
+
+	printf("per row: libm %.1f ns, oscillators %.1f ns%s\n", nsLibm, nsOsc,
+		sum == 42 ? " " : "");
+
+	return 0;
+}
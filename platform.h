@@ -0,0 +1,64 @@
+//
+//  platform.h : What the game core needs from the machine it runs on.
+//
+/* === NOTES ===
+	game.c only talks to the hardware through these. Main.c implements
+	them with libnds for the DS, host.c as no-ops plus a checksum for
+	headless runs on Linux.
+
+	Sprites live in one world spanning both screens: the main screen's
+	rows are y 0-191, a 6 line gap follows for the hinge, and the sub
+	screen starts at SUB_Y. The platform puts each sprite on whichever
+	screens it overlaps, so one crossing the gap shows on both.
+
+	A frame's sprites are added in front to back order (for the same
+	priority) and the platform shows exactly those at the next frame;
+	anything not added again is gone. Backgrounds and cues take effect at the frame boundary too,
+	like the old code did after its swiWaitForVBlank().
+
+	platTicks() is a free running counter for the profiler (prof.h);
+	it may wrap, and its rate is whatever the platform passes to
+	profInit().
+*/
+
+#ifndef __PLATFORM_H__
+#define __PLATFORM_H__
+
+#include "types.h"
+
+#define SCREEN_MAIN		0
+#define SCREEN_SUB		1
+
+#define SCREEN_W		256
+#define SCREEN_H		192
+#define SUB_Y			(SCREEN_H+6)
+
+// Sprite graphics; frames are 32x32 each.
+enum
+{
+	GFX_PUC,		// 6 frames
+	GFX_GIRD,		// 1 frame
+	GFX_GHOST,		// 3 frames
+};
+
+// Top screen backgrounds.
+enum
+{
+	BG_GAME,
+	BG_MENU,
+};
+
+// Audio cues. Only the music has a sound on the DS so far.
+enum
+{
+	CUE_MUSIC,
+	CUE_JUMP,
+	CUE_DIE,
+};
+
+void platSprite(int x, int y, int prio, int gfx, int frame, bool hflip);
+void platBackground(int bg);
+void platCue(int cue);
+u32 platTicks(void);
+
+#endif // __PLATFORM_H__
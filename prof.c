@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "prof.h"
+#include "platform.h"
+
+typedef struct ProfFrame
+{
+	u32 ticks[PROF_SECTIONS];
+} ProfFrame;
+
+static const char* names[PROF_SECTIONS] = {
+	[PROF_INPUT] = "input",
+	[PROF_GAME] = "game",
+	[PROF_COLL] = "collide",
+	[PROF_SPRITES] = "sprites",
+	[PROF_OAM] = "oam",
+	[PROF_WAIT] = "vblank",
+	[PROF_DEBUG] = "debug",
+};
+
+static u32 tick_hz = 1;
+static ProfFrame ring[PROF_FRAMES];
+static int head, frames;
+static ProfFrame cur;
+static u8 open[PROF_DEPTH];
+static int depth;
+static u32 last;
+
+void profInit(u32 hz){
+	tick_hz = hz;
+	memset(ring, 0, sizeof(ring));
+	memset(&cur, 0, sizeof(cur));
+	head = 0;
+	frames = 0;
+	depth = 0;
+}
+
+// Up to now goes to the section that was open, if any.
+void profBegin(int section){
+	u32 now = platTicks();
+	if( depth > 0 ) {
+		cur.ticks[open[depth-1]] += now - last;
+	}
+	if( depth < PROF_DEPTH ) {
+		open[depth++] = section;
+	}
+	last = now;
+}
+
+void profEnd(void){
+	u32 now = platTicks();
+	if( depth > 0 ) {
+		cur.ticks[open[--depth]] += now - last;
+	}
+	last = now;
+}
+
+void profAdd(int section, u32 ticks){
+	cur.ticks[section] += ticks;
+}
+
+void profFrame(void){
+	ring[head] = cur;
+	head = (head+1) % PROF_FRAMES;
+	frames += frames < PROF_FRAMES;
+	memset(&cur, 0, sizeof(cur));
+}
+
+int profFrames(void){
+	return frames;
+}
+
+static u32 toNs(u64 ticks){
+	return ticks * 1000000000 / tick_hz;
+}
+
+void profStats(int section, ProfStats* s){
+	u32 lo = ~0u, hi = 0;
+	u64 sum = 0;
+
+	for( int i = 0; i < frames; i++ ) {
+		u32 t = ring[i].ticks[section];
+		lo = t < lo ? t : lo;
+		hi = t > hi ? t : hi;
+		sum += t;
+	}
+	s->min = frames ? toNs(lo) : 0;
+	s->max = toNs(hi);
+	s->avg = frames ? toNs(sum / frames) : 0;
+}
+
+const char* profName(int section){
+	return names[section];
+}
@@ -0,0 +1,56 @@
+//
+//  prof.h : Frame profiler with scoped sections and a ring of frames.
+//
+/* === NOTES ===
+	profBegin()/profEnd() bracket a section of the frame; they nest, and
+	each section only gets the time not spent in the ones inside it, so
+	a frame's sections add up to the time covered. profFrame() closes
+	the frame into a ring of the last PROF_FRAMES, and profStats() gives
+	min, average and max per section over what's in the ring.
+
+	Time comes from platTicks() (see platform.h), which on the DS is
+	timers 0 and 1 cascaded at the 33.5 MHz bus clock, and on the host
+	the monotonic clock in ns. profInit() takes its rate.
+
+	IRQ handlers must not use profBegin(), as they could land in the
+	middle of one on the main loop; they time themselves and hand the
+	result to profAdd(). That time also still counts towards whatever
+	the IRQ interrupted, normally the VBlank wait.
+*/
+
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include "types.h"
+
+#define PROF_FRAMES		64
+#define PROF_DEPTH		8
+
+enum
+{
+	PROF_INPUT,
+	PROF_GAME,			// gameStep() minus the two below
+	PROF_COLL,
+	PROF_SPRITES,		// drawing into the shadow OAM, and sprEnd()
+	PROF_OAM,			// commit, from the VBlank IRQ
+	PROF_WAIT,
+	PROF_DEBUG,			// the debug overlays
+	PROF_SECTIONS
+};
+
+typedef struct ProfStats
+{
+	u32 min, avg, max;	// ns per frame
+} ProfStats;
+
+void profInit(u32 hz);
+void profBegin(int section);
+void profEnd(void);
+void profAdd(int section, u32 ticks);
+void profFrame(void);
+
+int profFrames(void);
+void profStats(int section, ProfStats* s);
+const char* profName(int section);
+
+#endif // __PROF_H__
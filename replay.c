@@ -0,0 +1,125 @@
+#include <string.h>
+
+#include "replay.h"
+
+// Most a run takes: u16 keys and a 5 byte count.
+#define RUN_MAX		7
+
+static void put32(u8* p, u32 v){
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static u32 get32(const u8* p){
+	return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+static u32 runSize(u32 count){
+	u32 n = 3;
+	while( count >= 0x80 ) {
+		count >>= 7;
+		n++;
+	}
+	return n;
+}
+
+static void flushRun(Replay* r){
+	u32 count = r->run;
+	r->buf[r->pos++] = r->keys;
+	r->buf[r->pos++] = r->keys >> 8;
+	while( count >= 0x80 ) {
+		r->buf[r->pos++] = count | 0x80;
+		count >>= 7;
+	}
+	r->buf[r->pos++] = count;
+}
+
+void replayRecordBegin(Replay* r, u8* buf, u32 size, u32 seed){
+	memset(r, 0, sizeof(Replay));
+	r->buf = buf;
+	r->size = size;
+	r->seed = seed;
+	r->pos = REPLAY_HEADER;
+	r->full = size < REPLAY_HEADER + RUN_MAX;
+}
+
+// There is always room left to flush the current run.
+bool replayRecord(Replay* r, u32 keys){
+	keys &= 0xFFFF;
+	if( r->full ) {
+		return false;
+	}
+	if( r->run == 0 || (keys == r->keys && r->run < 0xFFFFFFFF) ) {
+		r->keys = keys;
+		r->run++;
+	}
+	else {
+		if( r->pos + runSize(r->run) + RUN_MAX > r->size ) {
+			r->full = true;
+			return false;
+		}
+		flushRun(r);
+		r->keys = keys;
+		r->run = 1;
+	}
+	r->frames++;
+	return true;
+}
+
+// Returns the replay's size in bytes.
+u32 replayRecordEnd(Replay* r){
+	if( r->size < REPLAY_HEADER + RUN_MAX ) {
+		return 0;
+	}
+	if( r->run ) {
+		flushRun(r);
+		r->run = 0;
+	}
+	memcpy(r->buf, "PUCR", 4);
+	put32(r->buf + 4, r->seed);
+	put32(r->buf + 8, r->frames);
+	return r->pos;
+}
+
+bool replayPlayBegin(Replay* r, const u8* data, u32 size){
+	memset(r, 0, sizeof(Replay));
+	if( size < REPLAY_HEADER || memcmp(data, "PUCR", 4) != 0 ) {
+		return false;
+	}
+	r->data = data;
+	r->size = size;
+	r->pos = REPLAY_HEADER;
+	r->seed = get32(data + 4);
+	r->frames = get32(data + 8);
+	return true;
+}
+
+// Returns false at the end, or if the replay is cut short.
+bool replayPlay(Replay* r, u32* keys){
+	if( r->run == 0 ) {
+		u32 count = 0;
+		int shift = 0;
+
+		if( r->pos + 3 > r->size ) {
+			return false;
+		}
+		r->keys = r->data[r->pos] | r->data[r->pos+1] << 8;
+		r->pos += 2;
+		do {
+			if( r->pos >= r->size || shift > 28 ) {
+				return false;
+			}
+			count |= (u32)(r->data[r->pos] & 0x7F) << shift;
+			shift += 7;
+		} while( r->data[r->pos++] & 0x80 );
+		if( count == 0 ) {
+			return false;
+		}
+		r->run = count;
+	}
+	r->run--;
+	*keys = r->keys;
+	return true;
+}
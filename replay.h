@@ -0,0 +1,44 @@
+//
+//  replay.h : Recording and playing back the keys of a game.
+//
+/* === NOTES ===
+	A game is its seed plus the keys of every frame from gameInit() on,
+	so that is all a replay holds. Keys mostly stay the same for many
+	frames, so they are stored as runs:
+
+		"PUCR"  seed:u32  frames:u32	header, little endian
+		keys:u16  count:varint			one per run, count >= 1
+
+	The count is 7 bits a byte, low bits first, top bit set on all but
+	the last byte. A minute of play is typically a few hundred bytes.
+
+	Recording stops quietly when the buffer is full (replayRecord()
+	returns false); what fits is still a valid replay.
+*/
+
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "types.h"
+
+#define REPLAY_HEADER	12
+
+typedef struct Replay
+{
+	u8* buf;			// recording
+	const u8* data;		// playing
+	u32 size, pos;
+	u32 seed;
+	u32 frames;			// recorded so far, or in the replay
+	u32 keys, run;		// the current run
+	bool full;
+} Replay;
+
+void replayRecordBegin(Replay* r, u8* buf, u32 size, u32 seed);
+bool replayRecord(Replay* r, u32 keys);
+u32 replayRecordEnd(Replay* r);
+
+bool replayPlayBegin(Replay* r, const u8* data, u32 size);
+bool replayPlay(Replay* r, u32* keys);
+
+#endif // __REPLAY_H__
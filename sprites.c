@@ -0,0 +1,266 @@
+#include <string.h>
+
+#include "sprites.h"
+#include "platform.h"
+
+// The attribute bits we use; see GBATEK.
+#define A0_HIDE			(1<<9)
+#define A0_256COLOR		(1<<13)
+#define A1_HFLIP		(1<<12)
+#define A1_SIZE_32		(2<<14)
+#define A2_PRIO_SHIFT	10
+
+static void setEntry(SprOam* t, int slot, const u16* attr){
+	u16* e = &t->oam[slot*4];
+	if( e[0] != attr[0] || e[1] != attr[1] || e[2] != attr[2] ) {
+		e[0] = attr[0];
+		e[1] = attr[1];
+		e[2] = attr[2];
+		t->dirty[slot>>5] |= 1u << (slot&31);
+	}
+}
+
+// Everything hidden, and all of it dirty so the first commit writes it.
+void sprInit(SprOam* t){
+	memset(t, 0, sizeof(SprOam));
+	for( int i = 0; i < SPR_COUNT; i++ ) {
+		t->oam[i*4] = A0_HIDE;
+	}
+	memset(t->dirty, 0xFF, sizeof(t->dirty));
+}
+
+void sprBegin(SprOam* t){
+	t->count = 0;
+}
+
+// Returns the sprite's index in this frame's list, or -1 when it's full.
+int sprAdd(SprOam* t, int x, int y, int prio, int tile, bool hflip){
+	int i = t->count;
+	if( i >= SPR_MAX ) {
+		return -1;
+	}
+	t->count++;
+	SprEntry* e = &t->list[i];
+	e->attr[0] = (y & 0xFF) | A0_256COLOR;
+	e->attr[1] = (x & 0x1FF) | A1_SIZE_32 | (hflip ? A1_HFLIP : 0);
+	e->attr[2] = (tile & 0x3FF) | prio << A2_PRIO_SHIFT;
+	e->top = y;
+	e->slot = -1;
+	e->flickered = false;
+	return i;
+}
+
+// List indices by top, keeping the order they were added within a line.
+static void sortByTop(const SprOam* t, u16* order){
+	u16 at[256] = { 0 };
+	int i, k, sum = 0;
+
+	for( i = 0; i < t->count; i++ ) {
+		k = t->list[i].top + SPR_SIZE;
+		at[k < 0 ? 0 : k > 255 ? 255 : k]++;
+	}
+	for( k = 0; k < 256; k++ ) {
+		int n = at[k];
+		at[k] = sum;
+		sum += n;
+	}
+	for( i = 0; i < t->count; i++ ) {
+		k = t->list[i].top + SPR_SIZE;
+		order[at[k < 0 ? 0 : k > 255 ? 255 : k]++] = i;
+	}
+}
+
+// The first 128 by y get slots in y order. After that, all sprites are
+// the same height, so slots free up in the order they were filled: a
+// ring of slots by their sprite's top is all the bookkeeping needed.
+static int multiplex(SprOam* t, SprMux* m){
+	u16 order[SPR_MAX];
+	u8 ring[SPR_COUNT];
+	s16 bottom[SPR_COUNT];
+	u32 used[SPR_COUNT/32] = { 0 };
+	int head = 0;
+
+	int k = 0, filled = 0;
+
+	sortByTop(t, order);
+	for( ; filled < SPR_COUNT; k++ ) {
+		SprEntry* e = &t->list[order[k]];
+		if( e->flickered ) {
+			continue;
+		}
+		e->slot = filled;
+		setEntry(t, filled, e->attr);
+		ring[filled] = filled;
+		bottom[filled] = e->top + SPR_SIZE-1;
+		filled++;
+	}
+
+	for( ; k < t->count; k++ ) {
+		SprEntry* e = &t->list[order[k]];
+		int line = e->top - SPR_MUX_LEAD;
+		int slot = ring[head];
+
+		if( e->top >= SCREEN_H || e->flickered ) {
+			continue;
+		}
+		if( line < 0 || bottom[slot] >= line ) {
+			t->dropped++;
+			continue;
+		}
+		SprRewrite* r = &m->rw[m->count++];
+		memcpy(r->attr, e->attr, sizeof(r->attr));
+		r->line = line;
+		r->slot = slot;
+		e->slot = slot;
+		bottom[slot] = e->top + SPR_SIZE-1;
+		head = (head+1) % SPR_COUNT;
+		used[slot>>5] |= 1u << (slot&31);
+	}
+
+	for( int k = 0; k < SPR_COUNT; k++ ) {
+		if( used[k>>5] & 1u << (k&31) ) {
+			SprRewrite* r = &m->restore[m->restores++];
+			memcpy(r->attr, &t->oam[k*4], sizeof(r->attr));
+			r->line = 0;
+			r->slot = k;
+		}
+	}
+	return SPR_COUNT;
+}
+
+// Lines a sprite covers on screen, none if hi < lo.
+static void lineSpan(const SprEntry* e, int* lo, int* hi){
+	*lo = e->top < 0 ? 0 : e->top;
+	*hi = e->top + SPR_SIZE-1;
+	if( *hi >= SPR_LINES ) {
+		*hi = SPR_LINES-1;
+	}
+}
+
+// Fills t->cost and t->peak from the whole list; returns the lines
+// over budget.
+static int lineCost(SprOam* t){
+	s16 delta[SPR_LINES+1] = { 0 };
+	int i, lo, hi, sum = 0, peak = 0, over = 0;
+
+	for( i = 0; i < t->count; i++ ) {
+		lineSpan(&t->list[i], &lo, &hi);
+		if( lo <= hi ) {
+			delta[lo] += SPR_CYCLES;
+			delta[hi+1] -= SPR_CYCLES;
+		}
+	}
+	for( i = 0; i < SPR_LINES; i++ ) {
+		sum += delta[i];
+		t->cost[i] = sum;
+		peak = sum > peak ? sum : peak;
+		over += sum > SPR_LINE_CYCLES;
+	}
+	t->peak = peak;
+	return over;
+}
+
+// Sprites claim their lines in list order from a start that moves on
+// by one each frame; whatever no longer fits is left out.
+static void flicker(SprOam* t){
+	u16 load[SPR_LINES] = { 0 };
+	int start = t->frames % t->count;
+
+	for( int n = 0; n < t->count; n++ ) {
+		int i = start + n < t->count ? start + n : start + n - t->count;
+		SprEntry* e = &t->list[i];
+		int lo, hi, line;
+
+		lineSpan(e, &lo, &hi);
+		for( line = lo; line <= hi; line++ ) {
+			if( load[line] + SPR_CYCLES > SPR_LINE_CYCLES ) {
+				break;
+			}
+		}
+		if( line <= hi ) {
+			e->flickered = true;
+			t->flickered++;
+			continue;
+		}
+		for( line = lo; line <= hi; line++ ) {
+			load[line] += SPR_CYCLES;
+		}
+	}
+}
+
+void sprEnd(SprOam* t){
+	static const u16 hidden[3] = { A0_HIDE, 0, 0 };
+	SprMux* m = &t->mux[!t->front];
+	int used = 0;
+
+	m->count = 0;
+	m->restores = 0;
+	t->dropped = 0;
+	t->flickered = 0;
+	t->over = lineCost(t);
+	if( t->flicker && t->over ) {
+		flicker(t);
+	}
+	t->frames++;
+
+	if( t->count - t->flickered > SPR_COUNT ) {
+		used = multiplex(t, m);
+	}
+	else {
+		for( int i = 0; i < t->count; i++ ) {
+			SprEntry* e = &t->list[i];
+			if( !e->flickered ) {
+				e->slot = used;
+				setEntry(t, used++, e->attr);
+			}
+		}
+	}
+
+	for( int i = used; i < t->shown; i++ ) {
+		setEntry(t, i, hidden);
+	}
+	t->shown = used;
+}
+
+// t and tile are per screen, main then sub. Returns a bit per screen
+// the sprite went on.
+int sprAddWorld(SprOam* t, int x, int y, int prio, const int* tile, bool hflip){
+	int on = 0;
+	if( x <= -SPR_SIZE || x >= SCREEN_W ) {
+		return 0;
+	}
+	if( y > -SPR_SIZE && y < SCREEN_H ) {
+		if( sprAdd(&t[SCREEN_MAIN], x, y, prio, tile[SCREEN_MAIN], hflip) >= 0 ) {
+			on |= 1 << SCREEN_MAIN;
+		}
+	}
+	if( y > SUB_Y-SPR_SIZE && y < SUB_Y+SCREEN_H ) {
+		if( sprAdd(&t[SCREEN_SUB], x, y-SUB_Y, prio, tile[SCREEN_SUB], hflip) >= 0 ) {
+			on |= 1 << SCREEN_SUB;
+		}
+	}
+	return on;
+}
+
+// Number of entries from *first to the last dirty one, 0 if none.
+int sprDirtySpan(const SprOam* t, int* first){
+	int lo = -1, hi = -1;
+	for( int i = 0; i < SPR_COUNT/32; i++ ) {
+		u32 d = t->dirty[i];
+		if( d ) {
+			if( lo < 0 ) {
+				lo = i*32 + __builtin_ctz(d);
+			}
+			hi = i*32 + 31 - __builtin_clz(d);
+		}
+	}
+	*first = lo < 0 ? 0 : lo;
+	return lo < 0 ? 0 : hi - lo + 1;
+}
+
+// Call once the dirty span is in OAM; also switches to this frame's
+// rewrites.
+void sprClean(SprOam* t){
+	memset(t->dirty, 0, sizeof(t->dirty));
+	t->front = !t->front;
+}
@@ -0,0 +1,119 @@
+//
+//  sprites.h : Shadow OAM with dirty tracking and multiplexing.
+//
+/* === NOTES ===
+	One SprOam per screen. Each frame the game adds its sprites with
+	sprAdd() in front to back order, and sprEnd() turns that list into
+	the OAM for the next frame.
+
+	With up to 128 sprites they get slots 0 up in the order they were
+	added, so earlier ones are drawn over later ones of the same
+	priority. sprEnd() hides whatever was shown last frame and wasn't
+	added this time. An entry only gets written, and marked dirty, when
+	it changes; the VBlank handler copies the span from the first to the
+	last dirty entry into OAM and calls sprClean().
+
+	With more, they are multiplexed: sorted by y, the first 128 go into
+	the shadow as above, and each of the rest takes over the slot of a
+	sprite that has already been drawn. Those rewrites are listed by
+	scanline in an SprMux and done by the VCount IRQ as the beam gets
+	there. A rewrite at line L must be done with the old sprite (its
+	last line before L) and ahead of the new one (its top at least
+	L+SPR_MUX_LEAD), since the hardware reads OAM a line ahead. Sprites
+	that find no slot in time are dropped and their slot stays -1. In
+	this mode the front to back order only holds within slots, not
+	between them.
+
+	Every VBlank, the restore list of the rewrites that just ran puts
+	their slots back to what the shadow says, so the shadow and dirty
+	bits keep describing OAM at the top of the frame. sprClean() makes
+	the new frame's rewrites the ones to run.
+
+	All sprites are 32x32 in 256 colours; tile is the 128 byte unit
+	index of the gfx, as for SpriteMapping_1D_128.
+
+	The hardware also only has so much time per line for sprites:
+	SPR_LINE_CYCLES, of which a 32 pixel wide sprite takes SPR_CYCLES on
+	every line it covers, partly off screen or not. Past that, the
+	sprites furthest back in OAM lose pixels on that line. sprEnd()
+	adds up what the list asks of each line into cost[], and counts the
+	lines over budget in over. With flicker set, it then leaves sprites
+	out until every line fits: the sprites claim their lines in list
+	order, starting one further along each frame, and those that no
+	longer fit get no slot this frame. So which ones go rotates from
+	frame to frame, the same way every run, instead of the hardware
+	always cutting the same ones.
+
+	sprAddWorld() takes world coordinates (see platform.h), drops what
+	is off both screens and adds the rest to the main and/or sub list.
+*/
+
+#ifndef __SPRITES_H__
+#define __SPRITES_H__
+
+#include "types.h"
+
+#define SPR_COUNT		128
+#define SPR_SIZE		32
+#define SPR_MAX			512		// per screen and frame
+#define SPR_MUX_LEAD	3
+#define SPR_LINES		192
+#define SPR_LINE_CYCLES	2130	// per line, without H-Blank free; GBATEK
+#define SPR_CYCLES		SPR_SIZE	// per line of a sprite
+
+typedef struct SprEntry
+{
+	u16 attr[3];
+	s16 top;			// y of the first line
+	s16 slot;			// OAM slot, -1 if dropped
+	bool flickered;		// left out to stay in budget
+} SprEntry;
+
+typedef struct SprRewrite
+{
+	u16 attr[3];
+	u8 line;			// VCount to do it at
+	u8 slot;
+} SprRewrite;
+
+typedef struct SprMux
+{
+	int count;
+	SprRewrite rw[SPR_MAX-SPR_COUNT];	// by line
+	int restores;
+	SprRewrite restore[SPR_COUNT];		// line unused
+} SprMux;
+
+typedef struct SprOam
+{
+	u16 oam[SPR_COUNT*4] __attribute__((aligned(4)));
+	u32 dirty[SPR_COUNT/32];
+	int count;			// added this frame
+	int shown;			// slots used last frame
+	int dropped;		// sprites that got no slot this frame
+	SprEntry list[SPR_MAX];
+	SprMux mux[2];
+	int front;			// mux[front] is the one running
+	bool flicker;		// keep lines within SPR_LINE_CYCLES
+	u32 frames;
+	int over;			// lines over budget this frame
+	int peak;			// cycles on the worst line
+	int flickered;		// sprites left out for it
+	u16 cost[SPR_LINES];	// cycles each line asks for
+} SprOam;
+
+void sprInit(SprOam* t);
+void sprBegin(SprOam* t);
+int sprAdd(SprOam* t, int x, int y, int prio, int tile, bool hflip);
+void sprEnd(SprOam* t);
+int sprAddWorld(SprOam* t, int x, int y, int prio, const int* tile, bool hflip);
+
+int sprDirtySpan(const SprOam* t, int* first);
+void sprClean(SprOam* t);
+
+static inline const SprMux* sprMux(const SprOam* t)
+{
+	return &t->mux[t->front];
+}
+
+#endif // __SPRITES_H__
@@ -0,0 +1,24 @@
+//
+//  types.h : libnds' integer types, or the same on the host.
+//
+
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ARM9
+#include <nds/ndstypes.h>
+#else
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+#endif
+
+#endif // __TYPES_H__